@@ -16,6 +16,11 @@
 // back or front layer of the display
 uint16_t current_layer;
 
+// Frame buffers of the triple buffering in SDRAM, scanned out by layer 1
+tetrisSwapChain ESPL_SwapChain;
+uint32_t ESPL_DrawBuffer = ESPL_FrameBuffer(0);
+tetrisFillEngine ESPL_FillEngine;
+
 /**
  * Function which initializes the GPIOs.
  */
@@ -157,7 +162,7 @@ void gpioInit() {
 
 	LTDC_ITConfig(LTDC_FLAG_LI, ENABLE);
 	LTDC_ITConfig(LTDC_FLAG_RR, DISABLE);
-	LTDC_LIPConfig(324);
+	LTDC_LIPConfig(ESPL_LastActiveLine + 1);
 
 	current_layer = LCD_BACKGROUND_LAYER;
 }
@@ -172,6 +177,16 @@ void USART1_IRQHandler(void) {
 
 void LTDC_IRQHandler(void) {
 	if (LTDC_GetITStatus(LTDC_IT_LI)) {
+		// The line interrupt comes at the first line after the active area, switch
+		// to the newest frame presented while the display is blanked
+		int buffer = swapVBlank(&ESPL_SwapChain);
+		if (buffer >= 0) {
+			LTDC_LayerAddress(LTDC_Layer1, ESPL_FrameBuffer(buffer));
+			LTDC_ReloadConfig(LTDC_IMReload);
+			uint32_t line = LTDC->CPSR & LTDC_CPSR_CYPOS;
+			if (line >= ESPL_FirstActiveLine && line <= ESPL_LastActiveLine)
+				ESPL_SwapChain.torn++; // Too late, the new frame starts in the middle of the display
+		}
 		xSemaphoreGiveFromISR(ESPL_DisplayReady, NULL);
 		taskYIELD();
 		LTDC_ClearITPendingBit(LTDC_IT_LI);
@@ -192,6 +207,7 @@ void ESPL_SystemInit(void) {
 	NVIC_PriorityGroupConfig(NVIC_PriorityGroup_4);
 
 	/*Initialize LCD and library*/
+	fillSoftwareInit(&ESPL_FillEngine); // Until the application moves the fills elsewhere
 
 //	gdispSetOrientation(GDISP_ROTATE_270);
 //	gdispSetOrientation(GDISP_ROTATE_LANDSCAPE);
@@ -199,7 +215,12 @@ void ESPL_SystemInit(void) {
 	LTDC_DitherCmd(DISABLE);
 
 	LTDC_LayerAlpha(LTDC_Layer1, 0xFF);
-	LTDC_LayerAlpha(LTDC_Layer2, 0xFF);
+
+	// Layer 1 scans out the frame buffers of the swap chain, layer 2 is unused
+	swapInit(&ESPL_SwapChain);
+	LTDC_LayerCmd(LTDC_Layer2, DISABLE);
+	LTDC_LayerAddress(LTDC_Layer1, ESPL_FrameBuffer(ESPL_SwapChain.front));
+	ESPL_DrawBuffer = ESPL_FrameBuffer(swapAcquire(&ESPL_SwapChain));
 
 	LTDC_ReloadConfig(LTDC_IMReload);
 //	gdispSetOrientation(GDISP_ROTATE_270);
@@ -215,19 +236,16 @@ void ESPL_SystemInit(void) {
 	gpioInit();
 }
 
+/**
+ * Presents the frame drawn, shown from the next vertical blank on, and moves
+ * the drawing to a free frame buffer. Never waits for the display.
+ */
 void ESPL_DrawLayer() {
-
-	if (current_layer == LCD_BACKGROUND_LAYER) { //Background equals layer 1
-		LCD_SetLayer(LCD_FOREGROUND_LAYER);
-		LTDC_LayerAlpha(LTDC_Layer2, (uint8_t) 0x00);
-		LTDC_ReloadConfig(LTDC_IMReload);
-		current_layer = LCD_FOREGROUND_LAYER;
-	} else {
-		LCD_SetLayer(LCD_BACKGROUND_LAYER);
-		LTDC_LayerAlpha(LTDC_Layer2, (uint8_t) 0xff);
-		LTDC_ReloadConfig(LTDC_IMReload);
-		current_layer = LCD_BACKGROUND_LAYER;
-	}
+	fillWait(&ESPL_FillEngine); // The frame is complete once presented
+	taskENTER_CRITICAL();
+	swapPresent(&ESPL_SwapChain);
+	ESPL_DrawBuffer = ESPL_FrameBuffer(swapAcquire(&ESPL_SwapChain));
+	taskEXIT_CRITICAL();
 }
 
 void vApplicationStackOverflowHook(TaskHandle_t pxTask, char *pcTaskName) {
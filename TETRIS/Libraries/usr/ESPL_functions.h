@@ -7,6 +7,9 @@
 #ifndef ESPL_functions_INCLUDED
 #define ESPL_functions_INCLUDED
 
+#include "tetris_fill.h"
+#include "tetris_swapchain.h"
+
 // Buttons
 #define ESPL_Register_Button_A GPIOE
 #define ESPL_Register_Button_B GPIOE
@@ -41,10 +44,20 @@
 #define ESPL_ADC_VBat ADC2
 #define ESPL_Channel_VBat ADC_Channel_13
 
+// Display timing of LCD_Init, lines counted from the vertical sync
+#define ESPL_FirstActiveLine 4
+#define ESPL_LastActiveLine 323
+
+// Frame buffers in the external SDRAM, spaced like the layers of the LCD driver
+#define ESPL_FrameBuffer(n) (LCD_FRAME_BUFFER + (n) * BUFFER_OFFSET)
+
 extern QueueHandle_t ESPL_RxQueue;
 extern SemaphoreHandle_t ESPL_DisplayReady;
 
 extern uint16_t current_layer;
+extern tetrisSwapChain ESPL_SwapChain; // Dropped and torn frames of the display
+extern uint32_t ESPL_DrawBuffer; // Frame buffer the gdisp driver draws into
+extern tetrisFillEngine ESPL_FillEngine; // Fills of the gdisp driver, waited for before the CPU touches their pixels
 
 void USART1_IRQHandler(void);
 void LTDC_IRQHandler(void);
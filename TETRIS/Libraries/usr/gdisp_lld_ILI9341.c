@@ -28,6 +28,7 @@
 #include "gdisp_lld_config.h"
 #include "src/gdisp/gdisp_driver.h"
 #include "stm32f429i_discovery_lcd.h"
+#include "ESPL_functions.h"
 
 /*===========================================================================*/
 /* Driver local definitions.                                                 */
@@ -51,6 +52,16 @@
 /*===========================================================================*/
 /* Driver local functions.                                                   */
 /*===========================================================================*/
+
+/* Fill a rectangle of the frame buffer drawn into, in the coordinates of the
+ * portrait LCD. The LCD driver only knows the buffers of its 2 layers, the
+ * fill engine may still be writing when this returns. */
+static void fill_rect(coord_t x, coord_t y, coord_t cx, coord_t cy, color_t color) {
+	tetrisSurface surface;
+	surfaceInit(&surface, (uint16_t *)ESPL_DrawBuffer, GDISP_SCREEN_HEIGHT, GDISP_SCREEN_WIDTH);
+	fillRect(&ESPL_FillEngine, &surface, x, y, cx, cy, color);
+}
+
 static inline void init_board(GDisplay *g) {
 	g->board = 0;
 
@@ -117,15 +128,14 @@ LLDSPEC void gdisp_lld_draw_pixel(GDisplay *g) {
 		y = g->p.x;
 		break;
 	}
-	LCD_SetTextColor(g->p.color);
-	LCD_DrawLine(x, y, 1, LCD_DIR_HORIZONTAL);
+	/* A single pixel is not worth a fill, but a fill may still be writing it */
+	fillWait(&ESPL_FillEngine);
+	((uint16_t *)ESPL_DrawBuffer)[y * GDISP_SCREEN_HEIGHT + x] = g->p.color;
 }
 #endif
 
 #if GDISP_HARDWARE_FILLS
 LLDSPEC void gdisp_lld_fill_area(GDisplay *g) {
-	LCD_SetTextColor(g->p.color);
-
 	coord_t		x, y, cx, cy;
 
 	switch(g->g.Orientation) {
@@ -156,15 +166,14 @@ LLDSPEC void gdisp_lld_fill_area(GDisplay *g) {
 		break;
 	}
 
-	LCD_DrawFullRect(x, y, cx, cy);
+	fill_rect(x, y, cx, cy, g->p.color);
 }
 #endif
 
 #if GDISP_HARDWARE_CLEARS
 LLDSPEC	void gdisp_lld_clear(GDisplay *g) {
 	//LCD_Clear(g->p.color);
-	LCD_SetTextColor(g->p.color);
-	LCD_DrawFullRect(0,0,240,320);
+	fill_rect(0, 0, GDISP_SCREEN_HEIGHT, GDISP_SCREEN_WIDTH, g->p.color);
 }
 #endif
 
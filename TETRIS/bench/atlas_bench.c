@@ -0,0 +1,163 @@
+/**
+ * Host test and benchmark of the glyph atlas in tetris_atlas.
+ *
+ * A stand-in font draws every character as a pattern of its code, with an
+ * advance of its own and pixels reaching 2 columns beyond the advance on both
+ * sides, clipped to the surface like gdisp. The charset of the atlas is drawn
+ * by it onto the key color and captured, then random numbers and labels are
+ * drawn at random positions over random backgrounds, the right and bottom
+ * edges of the display included, once by the font and once from the atlas.
+ * Both must give the same pixels, in the display orientation and in the turned
+ * orientation of the frame buffers of the board, and a string with a character
+ * outside the charset must be left to the font, otherwise the run reports a
+ * MISMATCH. Reports the time per glyph drawn from the atlas, the stand-in font
+ * is no measure of the RLE decoding of the fonts of gdisp.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/atlas_bench [strings] [seed]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tetris_atlas.h"
+#include "tetris_random.h"
+#include "tetris_surface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define displayWidth 320
+#define displayHeight 240
+#define fontHeight 37
+#define fontColor 0x0000
+#define keyColor 0xF81F
+#define stripWidth 1024
+
+static uint16_t fontPixels[displayWidth * displayHeight], atlasPixels[displayWidth * displayHeight];
+static uint16_t strip[stripWidth * fontHeight];
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int fontAdvance(char c){
+	return c == ' ' ? 9 : 10 + c % 9;
+}
+
+/*
+ * Draw a string by the stand-in font, returns its width
+ */
+static int fontDrawText(const tetrisSurface *surface, int x, int y, const char *text){
+	int start = x;
+	for (; *text; text++){
+		int advance = fontAdvance(*text);
+		if (*text != ' ')
+			for (int row = 3; row < fontHeight - 4; row++)
+				for (int col = -2; col < advance + 2; col++){
+					int px = x + col, py = y + row;
+					if ((unsigned)(*text * 31 + row * 7 + col * 5 + row * col) % 5 == 0
+							&& px >= 0 && px < surface->width && py >= 0 && py < surface->height)
+						*surfacePixel(surface, px, py) = fontColor;
+				}
+		x += advance;
+	}
+	return x - start;
+}
+
+static void fillRect(const tetrisSurface *surface, int x, int y, int cx, int cy, uint16_t color){
+	for (int py = y; py < y + cy; py++)
+		for (int px = x; px < x + cx; px++)
+			if (px >= 0 && px < surface->width && py >= 0 && py < surface->height)
+				*surfacePixel(surface, px, py) = color;
+}
+
+static void buildAtlas(tetrisAtlas *atlas, const tetrisSurface *surface){
+	atlasInit(atlas, strip, stripWidth, fontHeight, keyColor);
+	for (const char *c = atlasCharset; *c; c++){
+		char str[2] = {*c, 0};
+		int advance = fontAdvance(*c);
+		fillRect(surface, 0, 0, advance + 2 * atlasBearing, fontHeight, keyColor);
+		fontDrawText(surface, atlasBearing, 0, str);
+		atlasCapture(atlas, surface, *c, atlasBearing, 0, advance);
+	}
+}
+
+static void makeString(tetrisRandom *random, char *str, int size){
+	static const char *labels[] = {"SCORE", "LEVEL", "LINE", "NEXT"};
+	switch (randomBelow(random, 4)){
+	case 0:
+		snprintf(str, size, "%s", labels[randomBelow(random, 4)]);
+		break;
+	case 1: // Not in the charset
+		snprintf(str, size, "%5d%c", (int)randomBelow(random, 1000), "abK:"[randomBelow(random, 4)]);
+		break;
+	default:
+		snprintf(str, size, "%5d", (int)randomBelow(random, 100000));
+		break;
+	}
+}
+
+static int runOrientation(const char *name, int rotated, long strings, unsigned seed){
+	tetrisSurface fontSurface, atlasSurface;
+	tetrisAtlas atlas;
+	tetrisRandom random;
+	long mismatches = 0, leftToFont = 0, charsetStrings = 0;
+	if (rotated){
+		surfaceInitRotated(&fontSurface, fontPixels, displayWidth, displayHeight);
+		surfaceInitRotated(&atlasSurface, atlasPixels, displayWidth, displayHeight);
+	}
+	else {
+		surfaceInit(&fontSurface, fontPixels, displayWidth, displayHeight);
+		surfaceInit(&atlasSurface, atlasPixels, displayWidth, displayHeight);
+	}
+	randomSeed(&random, seed);
+	buildAtlas(&atlas, &atlasSurface);
+	memcpy(fontPixels, atlasPixels, sizeof(fontPixels));
+
+	for (long n = 0; n < strings; n++){
+		char str[16];
+		makeString(&random, str, sizeof(str));
+		int x = (int)randomBelow(&random, displayWidth + 20) - 10, y = (int)randomBelow(&random, displayHeight + 10) - 10;
+		uint16_t background = (uint16_t)randomNext(&random);
+		int cx = 60 + (int)randomBelow(&random, 60), cy = 20 + (int)randomBelow(&random, 30);
+		fillRect(&fontSurface, x - 10, y - 5, cx, cy, background);
+		fillRect(&atlasSurface, x - 10, y - 5, cx, cy, background);
+		fontDrawText(&fontSurface, x, y, str);
+		if (atlasDrawText(&atlas, &atlasSurface, x, y, str))
+			charsetStrings++;
+		else {
+			leftToFont++;
+			mismatches += strspn(str, atlasCharset) == strlen(str); // The atlas refused a string it holds
+			fontDrawText(&atlasSurface, x, y, str);
+		}
+		mismatches += memcmp(fontPixels, atlasPixels, sizeof(fontPixels)) != 0;
+		memcpy(atlasPixels, fontPixels, sizeof(fontPixels)); // Go on from the same pixels after a mismatch
+	}
+
+	// Time per glyph
+	const char *text = "  123 45678 90SCORE LEVEL";
+	int glyphs = (int)strlen(text), repeats = 20000;
+	double t0 = now();
+	for (int n = 0; n < repeats; n++)
+		atlasDrawText(&atlas, &atlasSurface, 20 + n % 16, 100, text);
+	double t1 = now();
+	printf("%-9s %8ld %8ld %8ld %12.1f%s\n", name, charsetStrings, leftToFont, mismatches,
+			(t1 - t0) / repeats / glyphs * 1e9, mismatches ? "  MISMATCH" : "");
+	return mismatches != 0;
+}
+
+int main(int argc, char **argv){
+	long strings = argc > 1 ? atol(argv[1]) : 20000;
+	unsigned seed = argc > 2 ? (unsigned)atol(argv[2]) : 12345;
+	int failed = 0;
+	printf("%-9s %8s %8s %8s %12s\n", "layout", "atlas", "font", "differ", "ns/glyph");
+	failed |= runOrientation("display", 0, strings, seed);
+	failed |= runOrientation("turned", 1, strings, seed);
+	return failed;
+}
@@ -0,0 +1,405 @@
+/**
+ * Host benchmark of the playfield representation.
+ *
+ * Replays the same pseudo random input trace (every piece is rotated, shifted
+ * towards a random column and then falls with gravity ticks until it is fixed,
+ * followed by line clears) once on the former int map[20][10]
+ * playfield with per-cell collision and wall scans, erasing and re-stamping the
+ * falling tetris on every event, and once on the row-mask tetrisBoard with the
+ * shape masks and the falling tetris kept as an overlay, and reports moves per
+ * second.
+ *
+ * Both runs hash the playfield after every fixed tetris, so the run also checks
+ * that the row-mask playfield, which only tests the rows of the fixed tetris for
+ * full lines, behaves exactly like the former full scan. The drop distance taken
+ * from the column heights is compared with stepping every tetris down before it
+ * is fixed.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/board_bench [events] [seed]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tetris_board.h"
+#include "tetris_shape.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define defaultEvents (1 << 22)
+#define benchRuns 5
+
+enum benchInput { inRotate, inRight, inDown, inLeft, inRefresh };
+
+struct benchPiece {
+	int x, y, type, color;
+	int px[4], py[4];
+};
+
+struct benchResult {
+	long pieces;
+	long lines;
+	long games;
+	uint32_t hash; // Hash of the playfield after every fixed tetris
+};
+
+// Offsets and rotation successor of the 28 tetris types, as the former tetrisShape() switch laid them out
+static const int8_t shapeX[28][4] = {
+	{-1,0,0,1}, {0,-1,0,-1}, {0,1,-1,0}, {-1,-1,0,0}, {-1,0,1,1}, {0,0,-1,0}, {-1,-1,0,1},
+	{0,1,0,0}, {1,-1,0,1}, {-1,0,0,0}, {-1,0,1,-1}, {0,0,0,1}, {-1,0,0,0}, {0,-1,0,1},
+	{0,0,0,1}, {-1,0,1,0}, {-1,0,-1,0}, {0,0,0,0}, {0,-1,1,2}, {-1,0,0,1}, {0,-1,0,-1},
+	{0,1,-1,0}, {-1,-1,0,0}, {0,-1,-1,0}, {0,-1,-1,0}, {0,-1,-1,0}, {0,0,0,0}, {0,-1,1,2}
+};
+static const int8_t shapeY[28][4] = {
+	{0,0,1,1}, {-1,0,0,1}, {0,0,1,1}, {-1,0,0,1}, {0,0,0,1}, {-1,0,1,1}, {-1,0,0,0},
+	{-1,-1,0,1}, {-1,0,0,0}, {-1,-1,0,1}, {0,0,0,1}, {-1,0,1,1}, {0,-1,0,1}, {-1,0,0,0},
+	{-1,0,1,0}, {0,0,0,1}, {0,0,1,1}, {0,1,-1,-2}, {0,0,0,0}, {0,0,1,1}, {-1,0,0,1},
+	{0,0,1,1}, {-1,0,0,1}, {0,0,1,1}, {0,0,1,1}, {0,0,1,1}, {0,1,-1,-2}, {0,0,0,0}
+};
+static const int8_t shapeNext[28] = {
+	1, 0, 3, 2, 7, 4, 5, 6, 9, 10, 11, 8, 15, 12, 13, 14, 16, 18, 17, 20, 19, 22, 21, 23, 24, 25, 27, 26
+};
+
+#define scriptLength 8
+#define pieceNum 0x10000
+
+static uint8_t spawnTypes[pieceNum];
+static uint8_t scripts[pieceNum][scriptLength]; // Inputs of every piece before gravity takes over
+static int verify; // Hash the playfields, off while timing
+static long dropMismatches; // Wrong drop distances found while verifying
+
+/*
+ * Get the next input of the n-th piece, gravity ticks once its script is used up
+ */
+static int nextInput(long n, int *step){
+	if (*step < scriptLength)
+		return scripts[n & (pieceNum-1)][(*step)++];
+	return inRefresh;
+}
+
+static void shape(struct benchPiece *p){
+	for (int i = 0; i < 4; i++){
+		p->px[i] = p->x + shapeX[p->type][i];
+		p->py[i] = p->y + shapeY[p->type][i];
+	}
+}
+
+static void spawn(struct benchPiece *p, long n){
+	p->x = 4;
+	p->y = 0;
+	p->type = spawnTypes[n & (pieceNum-1)];
+	p->color = 1 + (n & 3);
+	shape(p);
+}
+
+static int leftOf(const struct benchPiece *p){
+	int min = 10;
+	for (int i = 0; i < 4; i++)
+		if (p->px[i] < min)
+			min = p->px[i];
+	return min;
+}
+
+static int rightOf(const struct benchPiece *p){
+	int max = -1;
+	for (int i = 0; i < 4; i++)
+		if (p->px[i] > max)
+			max = p->px[i];
+	return max;
+}
+
+static int topOf(const struct benchPiece *p){
+	for (int i = 0; i < 4; i++)
+		if (p->py[i] <= 0)
+			return 1;
+	return 0;
+}
+
+/*----------------------------------------int map[20][10] playfield----------------------------------------*/
+// Two spare rows above and a solid floor below keep the former indexing defined
+static int legacyStore[2 + 20 + 1][10];
+static int (*const legacyMap)[10] = legacyStore + 2;
+
+static void legacyReset(void){
+	memset(legacyStore, 0, sizeof(legacyStore));
+	for (int col = 0; col < 10; col++)
+		legacyMap[20][col] = 5;
+}
+
+static int legacyFree(const struct benchPiece *p){
+	for (int i = 0; i < 4; i++)
+		if (legacyMap[p->py[i]][p->px[i]] != 0)
+			return 0;
+	return 1;
+}
+
+static void legacyPrint(const struct benchPiece *p, int value){
+	for (int i = 0; i < 4; i++)
+		legacyMap[p->py[i]][p->px[i]] = value;
+}
+
+static int legacyMove(struct benchPiece *p, int in){
+	int x = p->x, y = p->y;
+	if (in == inDown || in == inRefresh)
+		p->y++;
+	else if (in == inLeft && leftOf(p) > 0)
+		p->x--;
+	else if (in == inRight && rightOf(p) < 9)
+		p->x++;
+	shape(p);
+	if (!legacyFree(p)){
+		p->x = x;
+		p->y = y;
+		shape(p);
+		return 0;
+	}
+	return 1;
+}
+
+static void legacyRotate(struct benchPiece *p){
+	int type = p->type;
+	p->type = shapeNext[type];
+	shape(p);
+	if (leftOf(p) < 0 || rightOf(p) > 9 || !legacyFree(p)){
+		p->type = type;
+		shape(p);
+	}
+}
+
+static int legacyClearLines(void){
+	int full[5], num = 0;
+	for (int row = 19; row >= 0; row--){
+		int isLineFull = 1;
+		for (int col = 0; col < 10; col++)
+			if (legacyMap[row][col] == 0){
+				isLineFull = 0;
+				break;
+			}
+		if (isLineFull){
+			full[++num] = row;
+			for (int col = 0; col < 10; col++)
+				legacyMap[row][col] = 0;
+		}
+	}
+	for (int n = num; n > 0; n--)
+		for (int row = full[n]; row > 0; row--)
+			for (int col = 0; col < 10; col++)
+				legacyMap[row][col] = legacyMap[row-1][col];
+	return num;
+}
+
+static uint32_t legacyHash(void){
+	uint32_t hash = 0;
+	for (int row = 0; row < 20; row++){
+		uint32_t mask = 0;
+		for (int col = 0; col < 10; col++)
+			if (legacyMap[row][col])
+				mask |= 1u << col;
+		hash = hash * 31 + mask;
+	}
+	return hash;
+}
+
+static struct benchResult runLegacy(long events){
+	struct benchResult r = {0, 0, 1, 0};
+	struct benchPiece p;
+	int step = 0;
+	legacyReset();
+	spawn(&p, 0);
+	for (long e = 0; e < events; e++){
+		int in = nextInput(r.pieces, &step);
+		legacyPrint(&p, 0);
+		if (in == inRotate){
+			legacyRotate(&p);
+			legacyPrint(&p, p.color);
+			continue;
+		}
+		if (legacyMove(&p, in) || in != inRefresh){
+			legacyPrint(&p, p.color);
+			continue;
+		}
+		legacyPrint(&p, p.color); // Lock
+		r.pieces++;
+		if (topOf(&p)){
+			legacyReset();
+			r.games++;
+		}
+		r.lines += legacyClearLines();
+		if (verify)
+			r.hash = r.hash * 16777619u ^ legacyHash();
+		spawn(&p, r.pieces);
+		step = 0;
+		if (!legacyFree(&p)){ // No room for the new tetris
+			legacyReset();
+			r.games++;
+		}
+	}
+	return r;
+}
+
+/*----------------------------------------tetrisBoard playfield----------------------------------------*/
+static tetrisBoard board;
+
+static void boardShape(struct benchPiece *p){
+	const tetrisShapeInfo *shape = &tetrisShapes[p->type];
+	for (int i = 0; i < 4; i++){
+		p->px[i] = p->x + shape->x[i];
+		p->py[i] = p->y + shape->y[i];
+	}
+}
+
+static void boardPrint(const struct benchPiece *p){
+	for (int i = 0; i < 4; i++)
+		boardSetCell(&board, p->px[i], p->py[i], (uint8_t)p->color);
+}
+
+static int boardMove(struct benchPiece *p, int in){
+	int x = p->x, y = p->y;
+	if (in == inDown || in == inRefresh)
+		y++;
+	else if (in == inLeft)
+		x--;
+	else if (in == inRight)
+		x++;
+	if (!shapeFits(&board, p->type, x, y))
+		return 0;
+	p->x = x;
+	p->y = y;
+	boardShape(p);
+	return 1;
+}
+
+static void boardRotate(struct benchPiece *p){
+	int next = tetrisShapes[p->type].next;
+	if (shapeFits(&board, next, p->x, p->y)){
+		p->type = next;
+		boardShape(p);
+	}
+}
+
+static int boardClearLines(const struct benchPiece *p){
+	uint32_t fullLines = boardFullRows(&board, shapeRows(p->type, p->y));
+	boardRemoveRows(&board, fullLines);
+	return boardRowCount(fullLines);
+}
+
+static uint32_t boardHash(void){
+	uint32_t hash = 0;
+	for (int row = 0; row < boardHeight; row++)
+		hash = hash * 31 + ((boardRow(&board, row) & boardFieldMask) >> boardWallBits);
+	return hash;
+}
+
+/*
+ * Compare the drop distance from the column heights with stepping the tetris down
+ */
+static int dropDistanceMatches(const struct benchPiece *p){
+	int distance = 0;
+	while (shapeFits(&board, p->type, p->x, p->y + distance + 1))
+		distance++;
+	return distance == shapeDropDistance(&board, p->type, p->x, p->y);
+}
+
+static struct benchResult runBoard(long events){
+	struct benchResult r = {0, 0, 1, 0};
+	struct benchPiece p;
+	int step = 0;
+	boardClear(&board);
+	spawn(&p, 0);
+	for (long e = 0; e < events; e++){
+		int in = nextInput(r.pieces, &step);
+		if (in == inRotate){
+			boardRotate(&p);
+			continue;
+		}
+		if (boardMove(&p, in) || in != inRefresh)
+			continue;
+		if (verify && !dropDistanceMatches(&p))
+			dropMismatches++;
+		boardPrint(&p); // Lock, the falling tetris is only an overlay until then
+		r.pieces++;
+		if (topOf(&p)){
+			boardClear(&board);
+			r.games++;
+		}
+		r.lines += boardClearLines(&p);
+		if (verify)
+			r.hash = r.hash * 16777619u ^ boardHash();
+		spawn(&p, r.pieces);
+		step = 0;
+		if (!shapeFits(&board, p.type, p.x, p.y)){ // No room for the new tetris
+			boardClear(&board);
+			r.games++;
+		}
+	}
+	return r;
+}
+
+/*----------------------------------------Driver----------------------------------------*/
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void makeTrace(uint32_t seed){
+	uint32_t lcg = seed;
+	for (long n = 0; n < pieceNum; n++){
+		lcg = lcg * 1664525u + 1013904223u;
+		spawnTypes[n] = (uint8_t)((lcg >> 16) % 28);
+		lcg = lcg * 1664525u + 1013904223u;
+		int rotations = lcg >> 30;
+		int shift = (int)((lcg >> 24) % 10) - 4; // Towards a random column
+		int step = 0;
+		for (int i = 0; i < rotations; i++)
+			scripts[n][step++] = inRotate;
+		for (int i = 0; i < abs(shift) && step < scriptLength; i++)
+			scripts[n][step++] = shift < 0 ? inLeft : inRight;
+		for (; step < scriptLength; step++)
+			scripts[n][step] = (lcg >> step) & 1 ? inDown : inRefresh;
+	}
+}
+
+int main(int argc, char **argv){
+	long events = argc > 1 ? atol(argv[1]) : defaultEvents;
+	makeTrace(argc > 2 ? (uint32_t)atol(argv[2]) : 12345);
+
+	// Best of several runs to filter out scheduling noise of the host
+	double legacyTime = 1e9, boardTime = 1e9;
+	for (int run = 0; run < benchRuns; run++){
+		double t0 = now();
+		runLegacy(events);
+		double t1 = now();
+		runBoard(events);
+		double t2 = now();
+		if (t1 - t0 < legacyTime)
+			legacyTime = t1 - t0;
+		if (t2 - t1 < boardTime)
+			boardTime = t2 - t1;
+	}
+
+	verify = 1;
+	struct benchResult before = runLegacy(events);
+	struct benchResult after = runBoard(events);
+
+	printf("events: %ld\n", events);
+	printf("int map[20][10]: %8.2f Mmoves/s  (pieces %ld, lines %ld, games %ld)\n",
+			events / legacyTime * 1e-6, before.pieces, before.lines, before.games);
+	printf("tetrisBoard    : %8.2f Mmoves/s  (pieces %ld, lines %ld, games %ld)\n",
+			events / boardTime * 1e-6, after.pieces, after.lines, after.games);
+	if (before.pieces != after.pieces || before.lines != after.lines || before.games != after.games
+			|| before.hash != after.hash){
+		printf("MISMATCH between the two playfields\n");
+		return 1;
+	}
+	if (dropMismatches){
+		printf("MISMATCH of %ld drop distances\n", dropMismatches);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,138 @@
+/**
+ * Host benchmark of line clearing on full stacks.
+ *
+ * Every row of the stack is filled except for one hole, then 1, 2, 3 or 4 rows
+ * are completed and cleared, once with the former checkFullLine/letLineDisappear
+ * on int map[20][10] (one full stack shift per cleared line) and once with the
+ * single-pass compaction of tetrisBoard. The time of restoring the stack before
+ * every clear is measured separately and subtracted.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/clear_bench [iterations]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tetris_board.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define defaultIterations 2000000
+
+static int legacyStart[20][10], legacyMap[20][10];
+static tetrisBoard boardStart, board;
+static volatile int sink;
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Former line clearing: record full rows while emptying them, then shift the
+ * whole stack down once for every recorded row
+ */
+static int legacyClear(void){
+	int fullLineNumber[5], num = 0;
+	for (int row = 19; row >= 0; row--){
+		int isLineFull = 1;
+		for (int col = 0; col < 10; col++){
+			if (legacyMap[row][col] == 0){
+				isLineFull = 0;
+				break;
+			}
+		}
+		if (isLineFull){
+			num++;
+			fullLineNumber[num] = row;
+			for (int col = 0; col < 10; col++)
+				legacyMap[row][col] = 0;
+		}
+	}
+	for (int n = num; n > 0; n--)
+		for (int row = fullLineNumber[n]; row > 0; row--)
+			for (int col = 0; col < 10; col++)
+				legacyMap[row][col] = legacyMap[row-1][col];
+	return num;
+}
+
+static int boardClearLines(void){
+	uint32_t lockedRows = 0xFu << (boardHeight - 4); // Rows of the vertical I tetris that completed the lines
+	uint32_t fullLines = boardFullRows(&board, lockedRows);
+	boardRemoveRows(&board, fullLines);
+	return boardRowCount(fullLines);
+}
+
+/*
+ * Build a stack with a hole in every row but the lowest lines, which are full.
+ * Row 0 stays empty as in any running game, since a block fixed there ends it.
+ */
+static void buildStack(int lines){
+	memset(legacyStart, 0, sizeof(legacyStart));
+	boardClear(&boardStart);
+	for (int row = 1; row < 20; row++){
+		int hole = row < 20 - lines ? (row * 7) % 10 : -1;
+		for (int col = 0; col < 10; col++){
+			int colorNum = col == hole ? 0 : 1 + (row + col) % 4;
+			legacyStart[row][col] = colorNum;
+			if (colorNum)
+				boardSetCell(&boardStart, col, row, (uint8_t)colorNum);
+		}
+	}
+}
+
+static int sameResult(void){
+	for (int row = 0; row < 20; row++)
+		for (int col = 0; col < 10; col++)
+			if (legacyMap[row][col] != boardGetColor(&board, col, row))
+				return 0;
+	return 1;
+}
+
+int main(int argc, char **argv){
+	long iterations = argc > 1 ? atol(argv[1]) : defaultIterations;
+	int failed = 0;
+
+	printf("%-6s %14s %14s %8s\n", "lines", "int map ns", "tetrisBoard ns", "speedup");
+	for (int lines = 1; lines <= 4; lines++){
+		buildStack(lines);
+
+		double t0 = now();
+		for (long i = 0; i < iterations; i++){
+			memcpy(legacyMap, legacyStart, sizeof(legacyMap));
+			sink = legacyMap[i % 20][i % 10];
+		}
+		double t1 = now();
+		for (long i = 0; i < iterations; i++){
+			memcpy(legacyMap, legacyStart, sizeof(legacyMap));
+			sink = legacyClear();
+		}
+		double t2 = now();
+		for (long i = 0; i < iterations; i++){
+			board = boardStart;
+			sink = boardRow(&board, i % 20);
+		}
+		double t3 = now();
+		for (long i = 0; i < iterations; i++){
+			board = boardStart;
+			sink = boardClearLines();
+		}
+		double t4 = now();
+
+		double legacyNs = ((t2 - t1) - (t1 - t0)) / iterations * 1e9;
+		double boardNs = ((t4 - t3) - (t3 - t2)) / iterations * 1e9;
+		printf("%-6d %14.1f %14.1f %7.1fx\n", lines, legacyNs, boardNs, legacyNs / boardNs);
+
+		if (!sameResult()){
+			printf("MISMATCH after clearing %d lines\n", lines);
+			failed = 1;
+		}
+	}
+	return failed;
+}
@@ -0,0 +1,125 @@
+/**
+ * Host test and benchmark of the button debouncing in tetris_debounce.
+ *
+ * Builds synthetic edge traces of the 6 buttons in microseconds: presses
+ * after random quiet times, every press and release with a burst of contact
+ * bounces shorter than the debounce time, some bounce pairs merged into one
+ * edge as when an interrupt comes late and reads the level once, and the
+ * timestamps wrapping at 2^32 during the trace. The edges of all buttons are
+ * handed to debounceEdge in time order with a debounceTick at 60 Hz, as the
+ * button and frame interrupts do. Every physical press must give exactly one
+ * press, otherwise the run reports a MISMATCH. Reports the time per edge.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/debounce_bench [presses per button] [seed]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tetris_debounce.h"
+#include "tetris_random.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define debounceTimeUs 5000
+#define bounceTimeUs 3000 // Longest burst of bounces, shorter than the debounce time
+#define frameTimeUs 16667
+
+struct traceEdge {
+	uint64_t time; // Microseconds from the start of the trace
+	uint8_t index;
+	uint8_t level;
+};
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Append a level change starting at time with a burst of bounces, ending on the new level
+ */
+static int addBurst(struct traceEdge *edges, int num, tetrisRandom *random, uint64_t time, int index, int level){
+	int bounces = (int)randomBelow(random, 5); // Pairs of bounces after the first edge
+	uint64_t step = bounces ? bounceTimeUs / (2 * bounces) : 0;
+	edges[num++] = (struct traceEdge){time, (uint8_t)index, (uint8_t)level};
+	for (int n = 0; n < bounces; n++){
+		time += 1 + randomBelow(random, (uint32_t)step);
+		if (randomBelow(random, 4) == 0){ // The interrupt comes late and reads the level once for 2 edges
+			time += 1 + randomBelow(random, (uint32_t)step);
+			edges[num++] = (struct traceEdge){time, (uint8_t)index, (uint8_t)level};
+			continue;
+		}
+		edges[num++] = (struct traceEdge){time, (uint8_t)index, (uint8_t)!level};
+		time += 1 + randomBelow(random, (uint32_t)step);
+		edges[num++] = (struct traceEdge){time, (uint8_t)index, (uint8_t)level};
+	}
+	return num;
+}
+
+static int compareEdges(const void *a, const void *b){
+	const struct traceEdge *x = a, *y = b;
+	return x->time < y->time ? -1 : x->time > y->time;
+}
+
+int main(int argc, char **argv){
+	int presses = argc > 1 ? atoi(argv[1]) : 200000;
+	unsigned seed = argc > 2 ? (unsigned)atol(argv[2]) : 12345;
+	int maxEdges = presses * debounceButtons * 20;
+	struct traceEdge *edges = malloc(sizeof(struct traceEdge) * maxEdges);
+	tetrisRandom random;
+	int num = 0, failed = 0;
+	randomSeed(&random, seed);
+
+	// Every button is pressed for 20 to 300 ms after 10 to 500 ms released
+	uint64_t end = 0;
+	for (int index = 0; index < debounceButtons; index++){
+		uint64_t time = 0;
+		for (int n = 0; n < presses; n++){
+			time += debounceTimeUs + bounceTimeUs + 2000 + randomBelow(&random, 490000);
+			num = addBurst(edges, num, &random, time, index, 0);
+			time += 20000 + randomBelow(&random, 280000);
+			num = addBurst(edges, num, &random, time, index, 1);
+		}
+		if (time > end)
+			end = time;
+	}
+	qsort(edges, num, sizeof(struct traceEdge), compareEdges);
+
+	// Start shortly before the timestamps wrap, the trace wraps many times
+	const uint32_t start = 0xFFFFFFFFu - 100000;
+	tetrisDebounce debounce;
+	int counted[debounceButtons] = {0};
+	double best = 1e9;
+	for (int run = 0; run < 5; run++){
+		debounceInit(&debounce, debounceTimeUs);
+		for (int n = 0; n < debounceButtons; n++)
+			counted[n] = 0;
+		uint64_t nextFrame = frameTimeUs;
+		double t0 = now();
+		for (int n = 0; n < num; n++){
+			while (nextFrame <= edges[n].time){
+				debounceTick(&debounce, start + (uint32_t)nextFrame);
+				nextFrame += frameTimeUs;
+			}
+			counted[edges[n].index] += debounceEdge(&debounce, edges[n].index, edges[n].level, start + (uint32_t)edges[n].time);
+		}
+		double t1 = now();
+		if (t1 - t0 < best)
+			best = t1 - t0;
+	}
+
+	printf("edges: %d over %.1f s, %d presses per button, seed %u\n", num, end * 1e-6, presses, seed);
+	for (int index = 0; index < debounceButtons; index++){
+		printf("button %c: %d presses%s\n", "ABCDEK"[index], counted[index], counted[index] == presses ? "" : "  MISMATCH");
+		failed |= counted[index] != presses;
+	}
+	printf("debounce: %.2f ns per edge\n", best / num * 1e9);
+	free(edges);
+	return failed;
+}
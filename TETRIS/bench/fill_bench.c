@@ -0,0 +1,167 @@
+/**
+ * Host test and benchmark of the rectangle fills in tetris_fill.
+ *
+ * Random rectangles, partly outside the screen, are filled by fillRect into a
+ * frame buffer in the turned orientation of the board and in the portrait
+ * orientation the gdisp driver fills in, and pixel by pixel into a reference.
+ * The software engine runs every fill at once. A second engine stands for the
+ * single transfer of the DMA2D: a fill only runs when the next one is started
+ * or the engine is waited for. After fillWait both must equal the reference,
+ * otherwise the run reports a MISMATCH. Reports the time the CPU spends in a
+ * clear of the screen and in the fill of a cell by the software engine, the
+ * cycles of the DMA2D are counted on the board and shown by K on the pause
+ * scene.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/fill_bench [fills] [seed]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tetris_fill.h"
+#include "tetris_random.h"
+#include "tetris_surface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define displayWidth 320
+#define displayHeight 240
+
+static uint16_t pixels[displayWidth * displayHeight], reference[displayWidth * displayHeight];
+
+static uint32_t nanoseconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+
+/*
+ * Engine of a single transfer in flight, run when the next one starts
+ */
+struct deferredEngine {
+	tetrisFill pending;
+	int busy;
+};
+
+static void deferredStart(void *context, const tetrisFill *fill){
+	struct deferredEngine *engine = context;
+	if (engine->busy)
+		fillRun(&engine->pending);
+	engine->pending = *fill;
+	engine->busy = 1;
+}
+
+static void deferredWait(void *context){
+	struct deferredEngine *engine = context;
+	if (engine->busy)
+		fillRun(&engine->pending);
+	engine->busy = 0;
+}
+
+static void referenceFill(const tetrisSurface *surface, int x, int y, int cx, int cy, uint16_t color){
+	for (int px = x; px < x + cx; px++)
+		for (int py = y; py < y + cy; py++)
+			if (px >= 0 && px < surface->width && py >= 0 && py < surface->height)
+				*surfacePixel(surface, px, py) = color;
+}
+
+static long runLayout(const char *name, int rotated, tetrisFillEngine *engine, long fills, unsigned seed){
+	tetrisSurface surface, referenceSurface;
+	tetrisRandom random;
+	long mismatches = 0;
+	int width = rotated ? displayWidth : displayHeight, height = rotated ? displayHeight : displayWidth;
+	if (rotated){
+		surfaceInitRotated(&surface, pixels, width, height);
+		surfaceInitRotated(&referenceSurface, reference, width, height);
+	}
+	else {
+		surfaceInit(&surface, pixels, width, height);
+		surfaceInit(&referenceSurface, reference, width, height);
+	}
+	memset(pixels, 0, sizeof(pixels));
+	memset(reference, 0, sizeof(reference));
+	randomSeed(&random, seed);
+	for (long n = 0; n < fills; n++){
+		int x, y, cx, cy;
+		switch (randomBelow(&random, 4)){
+		case 0: // Whole screen
+			x = y = 0;
+			cx = width;
+			cy = height;
+			break;
+		case 1: // Pixel of a glyph
+			x = (int)randomBelow(&random, width);
+			y = (int)randomBelow(&random, height);
+			cx = cy = 1;
+			break;
+		default: // Anywhere, partly outside the screen
+			x = (int)randomBelow(&random, width + 40) - 20;
+			y = (int)randomBelow(&random, height + 40) - 20;
+			cx = (int)randomBelow(&random, width / 2);
+			cy = (int)randomBelow(&random, height / 2);
+			break;
+		}
+		uint16_t color = (uint16_t)randomNext(&random);
+		fillRect(engine, &surface, x, y, cx, cy, color);
+		referenceFill(&referenceSurface, x, y, cx, cy, color);
+		if (randomBelow(&random, 8) == 0){ // The CPU reads the pixels
+			fillWait(engine);
+			mismatches += memcmp(pixels, reference, sizeof(pixels)) != 0;
+		}
+	}
+	fillWait(engine);
+	mismatches += memcmp(pixels, reference, sizeof(pixels)) != 0;
+	printf("%-9s %-9s %8lu %10lu %8ld%s\n", name, engine->start == deferredStart ? "deferred" : "software",
+			(unsigned long)engine->fills, (unsigned long)engine->pixels, mismatches, mismatches ? "  MISMATCH" : "");
+	return mismatches;
+}
+
+/*
+ * Clock counts of the software engine for a fill repeated
+ */
+static double timeFill(tetrisFillEngine *engine, const tetrisSurface *surface, int x, int y, int cx, int cy, int repeats){
+	double best = 1e18;
+	for (int run = 0; run < 3; run++){
+		engine->busy = 0;
+		for (int n = 0; n < repeats; n++)
+			fillRect(engine, surface, x, y, cx, cy, (uint16_t)n);
+		if ((double)engine->busy / repeats < best)
+			best = (double)engine->busy / repeats;
+	}
+	return best;
+}
+
+int main(int argc, char **argv){
+	long fills = argc > 1 ? atol(argv[1]) : 20000;
+	unsigned seed = argc > 2 ? (unsigned)atol(argv[2]) : 12345;
+	tetrisFillEngine engine;
+	struct deferredEngine deferred;
+	long failed = 0;
+
+	printf("%-9s %-9s %8s %10s %8s\n", "layout", "engine", "fills", "pixels", "differ");
+	for (int rotated = 0; rotated <= 1; rotated++){
+		fillSoftwareInit(&engine);
+		failed += runLayout(rotated ? "turned" : "portrait", rotated, &engine, fills, seed);
+		fillSoftwareInit(&engine);
+		deferred.busy = 0;
+		engine.context = &deferred;
+		engine.start = deferredStart;
+		engine.wait = deferredWait;
+		failed += runLayout(rotated ? "turned" : "portrait", rotated, &engine, fills, seed);
+	}
+
+	// CPU time of the software engine, the whole fill
+	tetrisSurface surface;
+	surfaceInit(&surface, pixels, displayHeight, displayWidth);
+	fillSoftwareInit(&engine);
+	engine.clock = nanoseconds;
+	double clear = timeFill(&engine, &surface, 0, 0, displayHeight, displayWidth, 2000);
+	double cell = timeFill(&engine, &surface, 20, 100, 10, 10, 200000);
+	printf("software clear %.0f ns, %.2f ns/pixel, cell %.1f ns\n", clear, clear / (displayWidth * displayHeight), cell);
+	return failed != 0;
+}
@@ -0,0 +1,240 @@
+/**
+ * Host benchmark of the game logic in tetris_core.
+ *
+ * Feeds a pseudo random button trace through getState and the operations of
+ * every state in the same order as the single mode of gameStateManagement,
+ * without drawing: rotations, moves, hard drops and gravity ticks until a game
+ * is over, then back through the main menu into the next game, every game
+ * seeded from the seed of the run. Every gravity tick stands for tickFrames
+ * frames of the gravity timer. Reports input events and fixed tetris per
+ * second, and a checksum of the final scores so runs of the same seed can be
+ * compared between builds. Every run of the same seed must give the same
+ * checksum, every bag of 7 tetris must hold all 7 shapes, and the gravity of
+ * every level and the auto shift of a held button must give exactly their
+ * cells and moves per frame however the frames are handed in.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/game_bench [events] [seed]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tetris_board.h"
+#include "tetris_game.h"
+#include "tetris_gravity.h"
+#include "tetris_shift.h"
+#include "tetris_random.h"
+#include "tetris_shape.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define defaultEvents 20000000
+#define traceLength 4096 // Power of 2
+#define benchRuns 5
+#define tickFrames 5 // Frames of the gravity timer between 2 gravity ticks
+
+struct benchResult {
+	long pieces;
+	long lines;
+	long games;
+	uint32_t checksum; // Score of every finished game
+};
+
+static button trace[traceLength];
+static tetrisGame game;
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Button mix of a player: a third gravity ticks, moves and rotations, and a few hard drops
+ */
+static void makeTrace(uint32_t seed){
+	static const button mix[16] = {
+		system_refresh, system_refresh, system_refresh, system_refresh, system_refresh,
+		A, A, B, B, B, D, D, D, C, C, K
+	};
+	uint32_t lcg = seed;
+	for (int n = 0; n < traceLength; n++){
+		lcg = lcg * 1664525u + 1013904223u;
+		trace[n] = mix[lcg >> 28];
+	}
+}
+
+static struct benchResult run(long events, unsigned seed){
+	struct benchResult r = {0, 0, 0, 0};
+	currentState state = gameMenu;
+	int frames = 0; // Frames of the gravity timer not handed to the game yet
+	gameReset(&game);
+	game.connected = 0;
+	for (long e = 0; e < events; e++){
+		button privateButton = trace[e & (traceLength - 1)];
+		if (state == gameMenu || state == gameOver)
+			privateButton = A; // Leave the game over scene and start the next game right away
+		currentState lastState = state;
+		if (privateButton == system_refresh)
+			frames += tickFrames;
+		state = getState(&game, state, privateButton);
+		switch(state){
+		case initGame:{
+			gameStart(&game, seed + (uint32_t)r.games);
+			frames = 0;
+			break;
+		}
+		case inGame:{
+			gameInput(&game, privateButton);
+			break;
+		}
+		case nextRound:{
+			int pieces = game.pieces;
+			if (privateButton == K || gameGravity(&game, frames, NULL))
+				gameRound(&game, privateButton);
+			frames = 0;
+			r.pieces += game.pieces - pieces;
+			break;
+		}
+		case gameOver:{
+			if (lastState != gameOver){
+				r.games++;
+				r.lines += game.lines;
+				r.checksum = r.checksum * 16777619u ^ (uint32_t)game.score;
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+	return r;
+}
+
+/*
+ * Check that the bag deals every shape once in every 7 tetris, telling shapes apart by their geometry
+ */
+static int bagIsFair(unsigned seed){
+	tetrisBag bag;
+	bagSeed(&bag, seed);
+	for (int n = 0; n < 1000; n++){
+		int seen[bagSize] = {0};
+		int shapeNum = 0;
+		for (int i = 0; i < bagSize; i++){
+			const tetrisShapeInfo *shape = &tetrisShapes[bagNextType(&bag)];
+			int key = 0; // Squares of the shape in a 4x4 grid, the same for all types of it after rotating 4 times
+			for (int r = 0; r < 4; r++){
+				int cells = 0;
+				for (int k = 0; k < 4; k++)
+					cells |= 1 << ((shape->y[k] + 2) * 4 + shape->x[k] + 1);
+				if (!r || cells < key)
+					key = cells;
+				shape = &tetrisShapes[shape->next];
+			}
+			int known = 0;
+			for (int k = 0; k < shapeNum; k++)
+				known |= seen[k] == key;
+			if (known)
+				return 0;
+			seen[shapeNum++] = key;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Check that the gravity of every level falls floor(frames * cells per frame)
+ * cells, with the frames handed in as random chunks
+ */
+static int gravityIsExact(unsigned seed){
+	tetrisRandom random;
+	randomSeed(&random, seed);
+	for (int level = 0; level < gravityLevels; level++){
+		tetrisGravity gravity;
+		gravityInit(&gravity, gravityTable[level], gravityLockFrames);
+		uint64_t frames = 0, cells = 0;
+		for (int n = 0; n < 100000; n++){
+			int chunk = (int)randomBelow(&random, 8);
+			frames += chunk;
+			cells += gravityAdvance(&gravity, chunk);
+			if (cells != frames * gravityTable[level] / gravityOne)
+				return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Hold a button for random chunks of frames, after n frames it must have repeated
+ * 1 + (n - delay) / repeat times once the delay is over, however the frames are chunked
+ */
+static int shiftIsExact(unsigned seed){
+	tetrisRandom random;
+	randomSeed(&random, seed);
+	for (int delay = 0; delay <= 16; delay++)
+		for (int repeat = 1; repeat <= 6; repeat++){
+			tetrisShift shift;
+			shiftInit(&shift, delay, repeat);
+			shiftPress(&shift, B);
+			long frames = 0, moves = 0;
+			for (int n = 0; n < 10000; n++){
+				int chunk = (int)randomBelow(&random, 8);
+				frames += chunk;
+				moves += shiftAdvance(&shift, 1, chunk);
+				if (moves != (frames < delay ? 0 : 1 + (frames - delay) / repeat))
+					return 0;
+			}
+			if (shiftAdvance(&shift, 0, 100) || shift.held >= 0) // Released
+				return 0;
+		}
+	tetrisShift shift;
+	shiftInit(&shift, 3, 0);
+	shiftPress(&shift, D);
+	return shiftAdvance(&shift, 1, 2) == 0 && shiftAdvance(&shift, 1, 1) == shiftToWall;
+}
+
+int main(int argc, char **argv){
+	long events = argc > 1 ? atol(argv[1]) : defaultEvents;
+	unsigned seed = argc > 2 ? (unsigned)atol(argv[2]) : 12345;
+	makeTrace(seed);
+
+	// Best of several runs to filter out scheduling noise of the host
+	double best = 1e9;
+	struct benchResult r = {0, 0, 0, 0};
+	int failed = 0;
+	for (int i = 0; i < benchRuns; i++){
+		double t0 = now();
+		struct benchResult last = r;
+		r = run(events, seed);
+		double t1 = now();
+		if (t1 - t0 < best)
+			best = t1 - t0;
+		if (i && (r.checksum != last.checksum || r.pieces != last.pieces)){
+			printf("MISMATCH between runs of the same seed\n");
+			failed = 1;
+		}
+	}
+	if (!bagIsFair(seed)){
+		printf("MISMATCH: a bag does not hold all 7 shapes\n");
+		failed = 1;
+	}
+	if (!gravityIsExact(seed)){
+		printf("MISMATCH: the gravity of a level loses fractions of a cell\n");
+		failed = 1;
+	}
+
+	if (!shiftIsExact(seed)){
+		printf("MISMATCH: the auto shift of a held button repeats at the wrong frames\n");
+		failed = 1;
+	}
+
+	printf("events: %ld  seed: %u\n", events, seed);
+	printf("input events : %10.2f M/s\n", events / best * 1e-6);
+	printf("tetris pieces: %10.2f k/s  (pieces %ld, lines %ld, games %ld, checksum %08x)\n",
+			r.pieces / best * 1e-3, r.pieces, r.lines, r.games, r.checksum);
+	return failed;
+}
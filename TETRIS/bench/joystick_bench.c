@@ -0,0 +1,193 @@
+/**
+ * Host test and benchmark of the analog joystick filter in tetris_joystick.
+ *
+ * Replays ADC sample streams of an axis at joystickSampleRate the way the
+ * firmware sees them: blocks of half the circular DMA buffer are filtered as
+ * they complete, and the moves are taken from the filter at every frame of the
+ * gravity timer. The synthetic streams add noise and spikes to the rest
+ * position and to held deflections of both directions. At rest the axis must
+ * not move, a held deflection must repeat at joystickRate of its deflection,
+ * and an axis held at the edge of the dead zone must leave it only once,
+ * otherwise the run reports a MISMATCH. Reports the time per sample.
+ *
+ * A recorded stream is replayed instead when a file is given, with a line of
+ * 2 samples per millisecond, the X axis (ADC3) first and the Y axis (ADC1)
+ * second, as dumped from the DMA buffers. The moves of every second are printed.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/joystick_bench [seed | samples file]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tetris_gravity.h"
+#include "tetris_joystick.h"
+#include "tetris_random.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define joystickSampleRate 1000 // Samples per second of every axis
+#define blockLength 16 // Half of the circular DMA buffer
+#define restValue 1950 // Rest position of the synthetic axis, off the middle of the range
+#define noiseAmplitude 48
+#define spikeChance 200 // One sample in 200 is a spike to the end of the range
+
+struct axisResult {
+	long moves; // Sum of the signed moves
+	int activations; // Times the axis left the dead zone
+	int direction; // Direction of the axis at the end of the stream
+};
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Append milliseconds of an axis held at value with noise and spikes
+ */
+static long addSamples(uint16_t *samples, long num, tetrisRandom *random, int value, int noise, long milliseconds){
+	for (long n = 0; n < milliseconds; n++){
+		int sample = value + (int)randomBelow(random, noise + 1) - (int)randomBelow(random, noise + 1);
+		if (randomBelow(random, spikeChance) == 0)
+			sample = randomBelow(random, 2) ? joystickSampleMask : 0;
+		if (sample < 0)
+			sample = 0;
+		if (sample > joystickSampleMask)
+			sample = joystickSampleMask;
+		samples[num++] = (uint16_t)sample;
+	}
+	return num;
+}
+
+/*
+ * Replay a stream of an axis, filtering every block and taking the moves of every frame.
+ * perSecond gets the moves of every second when given.
+ */
+static struct axisResult replay(const uint16_t *samples, long num, long *perSecond){
+	struct axisResult result = {0, 0, 0};
+	tetrisJoystick axis;
+	long frames = 0;
+	joystickAxisInit(&axis);
+	for (long n = blockLength; n <= num; n += blockLength){
+		joystickFilter(&axis, samples + n - blockLength, blockLength);
+		// The frames of the gravity timer passed until the end of the block
+		long frameCount = n * gravityFrameRate / joystickSampleRate;
+		while (frames < frameCount){
+			int lastDirection = axis.direction;
+			int moves = joystickMoves(&axis, 1);
+			frames++;
+			result.moves += moves;
+			result.activations += axis.direction && axis.direction != lastDirection;
+			if (perSecond)
+				perSecond[n / joystickSampleRate] += moves;
+		}
+	}
+	result.direction = axis.direction;
+	return result;
+}
+
+static int replayFile(const char *name){
+	FILE *file = fopen(name, "r");
+	if (!file){
+		printf("cannot open %s\n", name);
+		return 1;
+	}
+	long size = 1 << 16, num = 0;
+	uint16_t *x = malloc(sizeof(uint16_t) * size), *y = malloc(sizeof(uint16_t) * size);
+	unsigned sampleX, sampleY;
+	while (fscanf(file, "%u %u", &sampleX, &sampleY) == 2){
+		if (num == size){
+			size *= 2;
+			x = realloc(x, sizeof(uint16_t) * size);
+			y = realloc(y, sizeof(uint16_t) * size);
+		}
+		x[num] = (uint16_t)sampleX;
+		y[num] = (uint16_t)sampleY;
+		num++;
+	}
+	fclose(file);
+
+	long seconds = num / joystickSampleRate + 1;
+	long *movesX = calloc(seconds, sizeof(long)), *movesY = calloc(seconds, sizeof(long));
+	struct axisResult resultX = replay(x, num, movesX), resultY = replay(y, num, movesY);
+	printf("%s: %ld samples\n%6s %8s %8s\n", name, num, "second", "moves X", "moves Y");
+	for (long s = 0; s < seconds; s++)
+		printf("%6ld %8ld %8ld\n", s, movesX[s], movesY[s]);
+	printf("total  %8ld %8ld  (left the dead zone %d and %d times)\n", resultX.moves, resultY.moves,
+			resultX.activations, resultY.activations);
+	free(x);
+	free(y);
+	free(movesX);
+	free(movesY);
+	return 0;
+}
+
+int main(int argc, char **argv){
+	static const int deflections[] = {600, 900, 1300, 1700, 2047, 2600}; // The last one clips at the end of the range
+	const long holdTime = 10000;
+	int failed = 0;
+	if (argc > 1 && (argv[1][0] < '0' || argv[1][0] > '9'))
+		return replayFile(argv[1]);
+	unsigned seed = argc > 1 ? (unsigned)atol(argv[1]) : 12345;
+	uint16_t *samples = malloc(sizeof(uint16_t) * 4 * holdTime);
+	tetrisRandom random;
+	randomSeed(&random, seed);
+
+	// At rest
+	long num = addSamples(samples, 0, &random, restValue, noiseAmplitude, 2 * holdTime);
+	struct axisResult rest = replay(samples, num, NULL);
+	printf("rest: %ld moves%s\n", rest.moves, rest.moves || rest.activations ? "  MISMATCH" : "");
+	failed |= rest.moves || rest.activations;
+
+	// Held deflections, from rest and back
+	printf("%10s %10s %10s %10s\n", "deflection", "moves/s", "moves", "expected");
+	for (int sign = 1; sign >= -1; sign -= 2)
+		for (size_t d = 0; d < sizeof(deflections) / sizeof(deflections[0]); d++){
+			int deflection = sign * deflections[d];
+			num = addSamples(samples, 0, &random, restValue, noiseAmplitude, 1000);
+			num = addSamples(samples, num, &random, restValue + deflection, noiseAmplitude, holdTime);
+			num = addSamples(samples, num, &random, restValue, noiseAmplitude, 1000);
+			struct axisResult held = replay(samples, num, NULL);
+			int clipped = restValue + deflection > joystickSampleMask ? joystickSampleMask - restValue
+					: restValue + deflection < 0 ? -restValue : deflection;
+			double rate = joystickRate(clipped) / (double)gravityOne;
+			long expected = sign * (1 + (long)(rate * holdTime * gravityFrameRate / 1000));
+			// The filter takes a few blocks to settle at both ends of the hold, and a rare block of several
+			// spikes or a noisy rest position can add a move
+			int ok = labs(held.moves - expected) <= 2 + (long)(rate * 6) && held.activations == 1 && !held.direction;
+			printf("%10d %10.2f %10ld %10ld%s\n", deflection, rate * gravityFrameRate, held.moves, expected, ok ? "" : "  MISMATCH");
+			failed |= !ok;
+		}
+
+	// At the edge of the dead zone with more noise
+	num = addSamples(samples, 0, &random, restValue, noiseAmplitude, 1000);
+	num = addSamples(samples, num, &random, restValue + joystickDeadZone + 40, 3 * noiseAmplitude, holdTime);
+	struct axisResult edge = replay(samples, num, NULL);
+	printf("dead zone edge: left %d times%s\n", edge.activations, edge.activations == 1 ? "" : "  MISMATCH");
+	failed |= edge.activations != 1;
+
+	// Time of the filter per sample
+	num = addSamples(samples, 0, &random, restValue + 1000, noiseAmplitude, 4 * holdTime);
+	double best = 1e9;
+	volatile int sink = 0;
+	for (int run = 0; run < 5; run++){
+		tetrisJoystick axis;
+		joystickAxisInit(&axis);
+		double t0 = now();
+		for (int repeat = 0; repeat < 50; repeat++)
+			for (long n = blockLength; n <= num; n += blockLength)
+				sink += joystickFilter(&axis, samples + n - blockLength, blockLength);
+		double t1 = now();
+		if (t1 - t0 < best)
+			best = t1 - t0;
+	}
+	printf("filter: %.2f ns per sample\n", best / (50.0 * num) * 1e9);
+	free(samples);
+	return failed;
+}
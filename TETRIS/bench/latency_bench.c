@@ -0,0 +1,113 @@
+/**
+ * Host test and benchmark of the latency histograms in tetris_latency.
+ *
+ * Adds samples of several distributions to a histogram: small exact values,
+ * uniform, a long tail and values up to the end of the 32 bit range. Count,
+ * minimum, maximum and average must equal the exact ones, and every percentile
+ * must lie between the exact percentile of the sorted samples and 1/8 above
+ * it, otherwise the run reports a MISMATCH. Reports the time per sample added.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/latency_bench [samples] [seed]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tetris_latency.h"
+#include "tetris_random.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+enum distribution {small, uniform, tail, wide, distributions};
+
+static const char *distributionNames[distributions] = {"small", "uniform", "tail", "wide"};
+static const int permilles[] = {0, 10, 500, 900, 990, 999, 1000};
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t sample(tetrisRandom *random, int type){
+	switch (type){
+	case small:
+		return randomBelow(random, 16);
+	case uniform:
+		return 1000 + randomBelow(random, 84000);
+	case tail: // TIM5 counts of a latency around 50 us, half as likely for every doubling up to a few ms
+		return 800 + (randomBelow(random, 4200) << (__builtin_ctz(randomNext(random) | 0x20)));
+	default:
+		return randomNext(random) >> randomBelow(random, 32);
+	}
+}
+
+static int compareValues(const void *a, const void *b){
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+	return x < y ? -1 : x > y;
+}
+
+int main(int argc, char **argv){
+	long num = argc > 1 ? atol(argv[1]) : 1000000;
+	unsigned seed = argc > 2 ? (unsigned)atol(argv[2]) : 12345;
+	uint32_t *values = malloc(sizeof(uint32_t) * num);
+	tetrisRandom random;
+	int failed = 0;
+	randomSeed(&random, seed);
+
+	printf("%-12s %6s %10s %10s\n", "distribution", "permil", "exact", "histogram");
+	for (int type = 0; type < distributions; type++){
+		tetrisLatency latency;
+		uint64_t sum = 0;
+		latencyInit(&latency);
+		for (long n = 0; n < num; n++){
+			values[n] = sample(&random, type);
+			sum += values[n];
+			latencyAdd(&latency, values[n]);
+		}
+		qsort(values, num, sizeof(uint32_t), compareValues);
+		int ok = latency.count == (uint32_t)num && latency.min == values[0] && latency.max == values[num - 1]
+				&& latencyAverage(&latency) == (uint32_t)(sum / num);
+		if (!ok)
+			printf("%-12s count, min, max or average  MISMATCH\n", distributionNames[type]);
+		failed |= !ok;
+		for (size_t p = 0; p < sizeof(permilles) / sizeof(permilles[0]); p++){
+			long rank = (long)(((uint64_t)num * permilles[p] + 999) / 1000);
+			uint32_t exact = values[rank ? rank - 1 : 0];
+			uint32_t found = latencyPercentile(&latency, permilles[p]);
+			ok = found >= exact && found - exact <= exact / 8 + 1;
+			printf("%-12s %6d %10lu %10lu%s\n", distributionNames[type], permilles[p], (unsigned long)exact,
+					(unsigned long)found, ok ? "" : "  MISMATCH");
+			failed |= !ok;
+		}
+	}
+
+	// Time per sample
+	for (long n = 0; n < num; n++)
+		values[n] = sample(&random, tail);
+	double best = 1e9;
+	for (int run = 0; run < 5; run++){
+		tetrisLatency latency;
+		latencyInit(&latency);
+		double t0 = now();
+		for (int repeat = 0; repeat < 10; repeat++)
+			for (long n = 0; n < num; n++)
+				latencyAdd(&latency, values[n]);
+		double t1 = now();
+		if (t1 - t0 < best)
+			best = t1 - t0;
+		if (latency.count != (uint32_t)(10 * num))
+			failed = 1;
+	}
+	char line[80];
+	tetrisLatency empty;
+	latencyInit(&empty);
+	latencyFormat(&empty, "empty", 84, line, sizeof(line));
+	printf("%s\nadd: %.2f ns per sample\n", line, best / (10.0 * num) * 1e9);
+	free(values);
+	return failed;
+}
@@ -0,0 +1,125 @@
+/**
+ * Placement enumeration ("perft") reference suite and benchmark.
+ *
+ * Counts the placements of a fixed sequence of tetris on a set of reference
+ * boards to increasing depths with perftCount and compares them with the
+ * expected counts, which were produced by an independent enumeration over
+ * sets of squares. Any change of the collision, rotation or line clearing
+ * rules shows up as a MISMATCH. The time of the deepest count of every board
+ * gives the placements generated per second.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/perft_bench [max depth]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tetris_board.h"
+#include "tetris_perft.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define suiteDepth 4
+
+struct perftReference {
+	const char *name;
+	const char *rows[boardHeight]; // Lowest rows of the board from top to bottom, '#' is a fixed block
+	uint64_t nodes[suiteDepth]; // Expected counts for depth 1 to suiteDepth
+};
+
+// I, T, J, Z, O, L, S
+static const uint8_t sequence[] = {17, 12, 4, 0, 16, 8, 2};
+
+static const struct perftReference suite[] = {
+	{"empty", {NULL}, {17, 578, 20337, 372398}},
+	{"jagged", {
+		"..........",
+		"#.........",
+		"##...#....",
+		"###.###..#",
+		"####.#####",
+		NULL}, {17, 596, 21068, 388485}},
+	{"overhang", {
+		".....##...",
+		"..........",
+		"##........",
+		"###.##..##",
+		"#####.####",
+		NULL}, {22, 990, 41911, 874430}},
+	{"lines", {
+		"#########.",
+		"#########.",
+		"########..",
+		"####.#####",
+		NULL}, {17, 578, 20310, 371040}},
+	{"tall", {
+		".##.######",
+		".#########",
+		".#####.###",
+		".#########",
+		".####.####",
+		".#########",
+		".##.######",
+		".#########",
+		".#########",
+		".######.##",
+		".#########",
+		".#########",
+		".###.#####",
+		".#########",
+		".#########",
+		NULL}, {17, 523, 14353, 141105}},
+};
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void buildBoard(tetrisBoard *board, const struct perftReference *ref){
+	int rowNum = 0;
+	while (rowNum < boardHeight && ref->rows[rowNum])
+		rowNum++;
+	boardClear(board);
+	for (int i = 0; i < rowNum; i++)
+		for (int x = 0; x < boardWidth; x++)
+			if (ref->rows[i][x] == '#')
+				boardSetCell(board, x, boardHeight - rowNum + i, 1);
+}
+
+int main(int argc, char **argv){
+	int maxDepth = argc > 1 ? atoi(argv[1]) : suiteDepth;
+	uint64_t totalNodes = 0;
+	double totalTime = 0;
+	int failed = 0;
+	if (maxDepth > suiteDepth)
+		maxDepth = suiteDepth;
+
+	printf("%-10s %5s %12s %12s %10s\n", "board", "depth", "nodes", "expected", "Mnodes/s");
+	for (size_t n = 0; n < sizeof(suite) / sizeof(suite[0]); n++){
+		tetrisBoard board;
+		buildBoard(&board, &suite[n]);
+		for (int depth = 1; depth <= maxDepth; depth++){
+			double t0 = now();
+			uint64_t nodes = perftCount(&board, sequence, depth);
+			double t1 = now();
+			int ok = nodes == suite[n].nodes[depth - 1];
+			printf("%-10s %5d %12llu %12llu %10.2f%s\n", suite[n].name, depth, (unsigned long long)nodes,
+					(unsigned long long)suite[n].nodes[depth - 1], nodes / (t1 - t0) * 1e-6, ok ? "" : "  MISMATCH");
+			failed |= !ok;
+			if (depth == maxDepth){
+				totalNodes += nodes;
+				totalTime += t1 - t0;
+			}
+		}
+	}
+	printf("depth %d total: %llu nodes, %.2f Mnodes/s\n", maxDepth, (unsigned long long)totalNodes,
+			totalNodes / totalTime * 1e-6);
+	return failed;
+}
@@ -0,0 +1,250 @@
+/**
+ * Host test and benchmark of the dirty cell renderer in tetris_render.
+ *
+ * Records the snapshots of games played by a pseudo random button trace the
+ * way game_bench plays them, and draws every one of them into frame buffers in
+ * memory handed out by the swap chain, turned like the frame buffers of the
+ * board: as the whole scene, as the whole scene over a copy of the static
+ * layer, and with the shadow of every frame buffer over that layer. The static
+ * layer is drawn again when the mode of the game changes. The scenes of the
+ * other states are stood for by a fill of the whole buffer, which invalidates
+ * its shadow. Text is drawn as a pattern of the characters. Every frame buffer
+ * drawn over the static layer, with or without the shadow, must equal the same
+ * snapshot drawn as a whole, pixel by pixel, with the cells drawn by fills and
+ * with the cells drawn as tiles of tetris_tiles, otherwise the run reports a
+ * MISMATCH. Reports the draw calls and the time of a frame drawn every way.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/render_bench [frames] [seed]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tetris_game.h"
+#include "tetris_render.h"
+#include "tetris_snapshot.h"
+#include "tetris_surface.h"
+#include "tetris_swapchain.h"
+#include "tetris_tiles.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define tickFrames 5 // Frames of the gravity timer between 2 gravity ticks, as in game_bench
+#define otherScene 0x1234 // Pixel of the scenes of the other states
+
+typedef uint16_t screen[renderWidth * renderHeight];
+
+static const uint16_t palette[renderColors] = {
+	0x0400, 0xFFFF, 0x0000, 0xF800, // Background, panel, text, mode text
+	0xFFFF, 0xF800, 0xFFE0, 0x001F, 0xFD20 // Cells
+};
+
+enum renderer {whole, layered, dirty};
+
+static const char *rendererNames[] = {"whole", "hud", "dirty"};
+static screen screens[swapBuffers], reference, hud;
+static tetrisSurface screenSurfaces[swapBuffers], referenceSurface, hudSurface;
+static renderShadow shadows[swapBuffers];
+static tetrisTiles tiles;
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void screenFill(void *context, int x, int y, int cx, int cy, int color){
+	const tetrisSurface *surface = context;
+	int x1 = x + cx > renderWidth ? renderWidth : x + cx, y1 = y + cy > renderHeight ? renderHeight : y + cy;
+	for (int col = x < 0 ? 0 : x; col < x1; col++)
+		for (int row = y < 0 ? 0 : y; row < y1; row++)
+			*surfacePixel(surface, col, row) = palette[color];
+}
+
+static void screenBox(void *context, int x, int y, int cx, int cy, int color){
+	screenFill(context, x, y, cx, 1, color);
+	screenFill(context, x, y + cy - 1, cx, 1, color);
+	screenFill(context, x, y, 1, cy, color);
+	screenFill(context, x + cx - 1, y, 1, cy, color);
+}
+
+/*
+ * Characters 12 pixels apart, a pattern of the character code within 10x18 pixels
+ */
+static void screenText(void *context, int x, int y, const char *text, int color){
+	for (; *text; text++, x += 12){
+		if (*text == ' ')
+			continue;
+		for (int row = 4; row < 22; row++)
+			for (int col = 0; col < 10; col++)
+				if ((unsigned)(*text * 13 + row * 5 + col * 3) % 7 < 2)
+					screenFill(context, x + col, y + row, 1, 1, color);
+	}
+}
+
+static void screenCopy(void *context, int x, int y, int cx, int cy){
+	surfaceCopy(context, &hudSurface, x, y, cx, cy);
+}
+
+/*
+ * Tile copied pixel by pixel
+ */
+static void screenTile(void *context, int x, int y, int look){
+	const tetrisSurface *tile = tilesLook(&tiles, look);
+	for (int col = 0; col < tile->width; col++)
+		for (int row = 0; row < tile->height; row++)
+			*surfacePixel(context, x + col, y + row) = *surfacePixel(tile, col, row);
+}
+
+/*
+ * Record the snapshots of the games played by a button trace, the scenes of the
+ * other states included
+ */
+static long recordGames(tetrisSnapshot *snapshots, long frames, unsigned seed){
+	static const button mix[16] = {
+		system_refresh, system_refresh, system_refresh, system_refresh, system_refresh,
+		A, A, B, B, B, D, D, D, C, C, K
+	};
+	static tetrisGame game;
+	currentState state = gameMenu;
+	uint32_t lcg = seed;
+	int gravityFrames = 0, games = 0;
+	gameReset(&game);
+	game.connected = 0;
+	for (long n = 0; n < frames; n++){
+		lcg = lcg * 1664525u + 1013904223u;
+		button privateButton = mix[lcg >> 28];
+		if (state == gameMenu || state == gameOver)
+			privateButton = A;
+		currentState lastState = state;
+		if (privateButton == system_refresh)
+			gravityFrames += tickFrames;
+		state = getState(&game, state, privateButton);
+		switch(state){
+		case initGame:
+			gameStart(&game, seed + (uint32_t)games);
+			gravityFrames = 0;
+			break;
+		case inGame:
+			gameInput(&game, privateButton);
+			break;
+		case nextRound:
+			if (privateButton == K || gameGravity(&game, gravityFrames, NULL))
+				gameRound(&game, privateButton);
+			gravityFrames = 0;
+			break;
+		case gameOver:
+			games += lastState != gameOver;
+			break;
+		default:
+			break;
+		}
+		snapshotCapture(&snapshots[n], &game, state, snapshotPause);
+		snapshots[n].mode = games % 3 == 1 ? doublePlayerMove : games % 3 == 2 ? doublePlayerRotate : singlePlayer;
+	}
+	return games;
+}
+
+static int isGameScene(const tetrisSnapshot *snapshot){
+	return snapshot->state == initGame || snapshot->state == inGame || snapshot->state == nextRound;
+}
+
+/*
+ * Draw all snapshots through the swap chain with a vertical blank every 1 to 4
+ * frames by a renderer, with the cells as tiles or by fills. Returns the frames
+ * not equal to the whole scene when checked, and the draw calls of the game
+ * scenes, the static layer excluded.
+ */
+static long drawAll(const tetrisSnapshot *snapshots, long frames, enum renderer renderer, int tiled, int check,
+		uint64_t *calls, uint32_t *maxCalls){
+	tetrisSwapChain chain;
+	void (*tile)(void *, int, int, int) = tiled ? screenTile : NULL;
+	renderTarget target = {NULL, screenFill, screenBox, screenText, renderer == whole ? NULL : screenCopy, tile, 0};
+	renderTarget wholeTarget = {&referenceSurface, screenFill, screenBox, screenText, NULL, tile, 0};
+	renderTarget hudTarget = {&hudSurface, screenFill, screenBox, screenText, NULL, tile, 0};
+	int hudMode = -1;
+	uint32_t lcg = 1;
+	long mismatches = 0;
+	swapInit(&chain);
+	memset(shadows, 0, sizeof(shadows));
+	*calls = 0;
+	*maxCalls = 0;
+	for (long n = 0; n < frames; n++){
+		int buffer = swapAcquire(&chain);
+		target.context = &screenSurfaces[buffer];
+		if (isGameScene(&snapshots[n])){
+			if (renderer != whole && (int)snapshots[n].mode != hudMode){
+				renderHud(&hudTarget, snapshots[n].mode);
+				hudMode = snapshots[n].mode;
+			}
+			renderGame(&target, renderer == dirty ? &shadows[buffer] : NULL, &snapshots[n]);
+			*calls += target.calls;
+			if (target.calls > *maxCalls)
+				*maxCalls = target.calls;
+			if (check){
+				renderGame(&wholeTarget, NULL, &snapshots[n]);
+				mismatches += memcmp(reference, screens[buffer], sizeof(screen)) != 0;
+			}
+		}
+		else {
+			screenFill(&screenSurfaces[buffer], 0, 0, renderWidth, renderHeight, 0);
+			shadows[buffer].valid = 0;
+		}
+		swapPresent(&chain);
+		lcg = lcg * 1664525u + 1013904223u;
+		if (lcg >> 30 == 0)
+			swapVBlank(&chain);
+	}
+	return mismatches;
+}
+
+int main(int argc, char **argv){
+	long frames = argc > 1 ? atol(argv[1]) : 20000;
+	unsigned seed = argc > 2 ? (unsigned)atol(argv[2]) : 12345;
+	tetrisSnapshot *snapshots = malloc(sizeof(tetrisSnapshot) * frames);
+	long scenes = 0;
+	int failed = 0;
+
+	long games = recordGames(snapshots, frames, seed);
+	for (long n = 0; n < frames; n++)
+		scenes += isGameScene(&snapshots[n]);
+	printf("%ld frames, %ld of the game scene, %ld games\n", frames, scenes, games);
+
+	for (int buffer = 0; buffer < swapBuffers; buffer++)
+		surfaceInitRotated(&screenSurfaces[buffer], screens[buffer], renderWidth, renderHeight);
+	surfaceInitRotated(&referenceSurface, reference, renderWidth, renderHeight);
+	surfaceInitRotated(&hudSurface, hud, renderWidth, renderHeight);
+
+	tilesInit(&tiles, palette + renderCellColor, 1);
+
+	uint64_t calls;
+	uint32_t maxCalls;
+	for (int tiled = 0; tiled <= 1; tiled++)
+		for (int renderer = layered; renderer <= dirty; renderer++){
+			long mismatches = drawAll(snapshots, frames, renderer, tiled, 1, &calls, &maxCalls);
+			printf("%s frames%s equal to the whole scene: %ld of %ld%s\n", rendererNames[renderer], tiled ? " of tiles" : "",
+					scenes - mismatches, scenes, mismatches ? "  MISMATCH" : "");
+			failed |= mismatches != 0;
+		}
+
+	printf("%-8s %12s %10s %12s\n", "renderer", "calls/frame", "max calls", "us/frame");
+	for (int renderer = whole; renderer <= dirty; renderer++){
+		double best = 1e9;
+		for (int run = 0; run < 3; run++){
+			double t0 = now();
+			drawAll(snapshots, frames, renderer, 0, 0, &calls, &maxCalls);
+			double t1 = now();
+			if (t1 - t0 < best)
+				best = t1 - t0;
+		}
+		printf("%-8s %12.1f %10lu %12.2f\n", rendererNames[renderer], (double)calls / scenes, (unsigned long)maxCalls,
+				best / frames * 1e6);
+	}
+	free(snapshots);
+	return failed;
+}
@@ -0,0 +1,93 @@
+/**
+ * Host benchmark of the multithreaded placement search.
+ *
+ * Counts the placements of the perft_bench sequence on an empty board and on a
+ * board with overhangs once with the single threaded perftCount as reference,
+ * then with searchCount from 1 to N threads with and without the transposition
+ * table, and reports the speedup over 1 thread. Every count must equal the
+ * reference, otherwise the run reports a MISMATCH.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/search_bench [depth] [max threads]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tetris_board.h"
+#include "tetris_perft.h"
+#include "tetris_search.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define defaultDepth 5
+#define tableBits 20 // 16 MiB of entries
+
+// I, T, J, Z, O, L, S, as in perft_bench
+static const uint8_t sequence[] = {17, 12, 4, 0, 16, 8, 2};
+
+static const char *overhangRows[] = {
+	".....##...",
+	"..........",
+	"##........",
+	"###.##..##",
+	"#####.####",
+};
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int benchBoard(const char *name, const tetrisBoard *board, int depth, int maxThreads){
+	int failed = 0;
+	double t0 = now();
+	uint64_t reference = perftCount(board, sequence, depth);
+	double t1 = now();
+	printf("%s, depth %d: %llu nodes, perftCount %.3f s\n", name, depth, (unsigned long long)reference, t1 - t0);
+	printf("%7s %6s %10s %8s %10s %7s %7s %8s\n", "threads", "table", "seconds", "speedup", "Mnodes/s", "tasks", "steals", "hits");
+
+	for (int table = 0; table <= 1; table++){
+		double single = 0;
+		for (int threads = 1; threads <= maxThreads; threads++){
+			searchStats stats;
+			double t2 = now();
+			uint64_t nodes = searchCount(board, sequence, depth, threads, table ? tableBits : 0, &stats);
+			double t3 = now();
+			if (threads == 1)
+				single = t3 - t2;
+			printf("%7d %6s %10.3f %7.2fx %10.2f %7llu %7llu %7.1f%%%s\n", threads, table ? "on" : "off", t3 - t2,
+					single / (t3 - t2), nodes / (t3 - t2) * 1e-6, (unsigned long long)stats.tasks,
+					(unsigned long long)stats.steals,
+					stats.tableProbes ? 100.0 * stats.tableHits / stats.tableProbes : 0.0,
+					nodes == reference ? "" : "  MISMATCH");
+			failed |= nodes != reference;
+		}
+	}
+	return failed;
+}
+
+int main(int argc, char **argv){
+	int depth = argc > 1 ? atoi(argv[1]) : defaultDepth;
+	int maxThreads = argc > 2 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+	int failed = 0;
+	tetrisBoard board;
+	if (maxThreads < 1)
+		maxThreads = 1;
+
+	boardClear(&board);
+	failed |= benchBoard("empty", &board, depth, maxThreads);
+
+	int rowNum = sizeof(overhangRows) / sizeof(overhangRows[0]);
+	for (int i = 0; i < rowNum; i++)
+		for (int x = 0; x < boardWidth; x++)
+			if (overhangRows[i][x] == '#')
+				boardSetCell(&board, x, boardHeight - rowNum + i, 1);
+	failed |= benchBoard("overhang", &board, depth, maxThreads);
+	return failed;
+}
@@ -0,0 +1,152 @@
+/**
+ * Host test and benchmark of the game state snapshots in tetris_snapshot.
+ *
+ * A writer thread publishes snapshots with a short pause for the game logic
+ * in between, every field derived from the sequence number, while a reader
+ * thread takes the newest one, checks it field by field, spins for a while as
+ * if drawing and checks it again before giving it back. A snapshot changing or mixing two
+ * sequence numbers while it is held, a renderer going back in sequence, or
+ * counts that do not add up to the published snapshots report a MISMATCH.
+ * Reports published, rendered and skipped snapshots and the time per snapshot.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/snapshot_bench [snapshots] [draw spins]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#define logicSpins 500 // Busy loop of the writer per snapshot, standing for the game logic
+
+#include "tetris_snapshot.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct benchShared {
+	tetrisSnapshots snapshots;
+	pthread_mutex_t lock;
+	long count; // Snapshots to publish
+	long spins; // Busy loop of the reader per snapshot, standing for drawing
+	volatile int done;
+	long torn, backwards;
+};
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fillSnapshot(tetrisSnapshot *snapshot, uint32_t value){
+	memset(&snapshot->board, (int)(value & 0xFF), sizeof(snapshot->board));
+	snapshot->current.type = (int)value;
+	snapshot->next.type = (int)(value * 7);
+	snapshot->score = (int)value;
+	snapshot->level = (int)(value % 15);
+	snapshot->lines = (int)(value ^ 0x5A5A);
+}
+
+/*
+ * Check that every field of a snapshot comes from the same value, the score
+ */
+static int snapshotIsWhole(const tetrisSnapshot *snapshot){
+	uint32_t value = (uint32_t)snapshot->score;
+	const uint8_t *bytes = (const uint8_t *)&snapshot->board;
+	for (size_t n = 0; n < sizeof(snapshot->board); n++)
+		if (bytes[n] != (value & 0xFF))
+			return 0;
+	return snapshot->current.type == (int)value && snapshot->next.type == (int)(value * 7)
+			&& snapshot->level == (int)(value % 15) && snapshot->lines == (int)(value ^ 0x5A5A)
+			&& snapshot->sequence == value;
+}
+
+static void *writerThread(void *arg){
+	struct benchShared *shared = arg;
+	for (long n = 1; n <= shared->count; n++){
+		pthread_mutex_lock(&shared->lock);
+		tetrisSnapshot *snapshot = snapshotBeginWrite(&shared->snapshots);
+		pthread_mutex_unlock(&shared->lock);
+		fillSnapshot(snapshot, (uint32_t)n); // Outside the lock, as the game task copies the game
+		pthread_mutex_lock(&shared->lock);
+		snapshotEndWrite(&shared->snapshots);
+		pthread_mutex_unlock(&shared->lock);
+		for (volatile long spin = 0; spin < logicSpins; spin++)
+			;
+		sched_yield(); // Wait for the next event, the renderer runs meanwhile on a single core
+	}
+	shared->done = 1;
+	return NULL;
+}
+
+static void *readerThread(void *arg){
+	struct benchShared *shared = arg;
+	uint32_t last = 0;
+	while (1){
+		int done = shared->done;
+		pthread_mutex_lock(&shared->lock);
+		const tetrisSnapshot *snapshot = snapshotAcquire(&shared->snapshots);
+		pthread_mutex_unlock(&shared->lock);
+		if (!snapshot){
+			if (done)
+				break;
+			sched_yield();
+			continue;
+		}
+		uint32_t sequence = snapshot->sequence;
+		int whole = snapshotIsWhole(snapshot);
+		for (long part = 0; part < 4; part++){ // The game task preempts the drawing
+			for (volatile long spin = 0; spin < shared->spins; spin++)
+				;
+			sched_yield();
+		}
+		whole &= snapshotIsWhole(snapshot) && snapshot->sequence == sequence;
+		shared->torn += !whole;
+		shared->backwards += sequence <= last;
+		last = sequence;
+		pthread_mutex_lock(&shared->lock);
+		snapshotRelease(&shared->snapshots);
+		pthread_mutex_unlock(&shared->lock);
+	}
+	return NULL;
+}
+
+int main(int argc, char **argv){
+	static struct benchShared shared;
+	shared.count = argc > 1 ? atol(argv[1]) : 200000;
+	long maxSpins = argc > 2 ? atol(argv[2]) : 20000;
+	int failed = 0;
+
+	printf("%8s %10s %10s %10s %12s\n", "spins", "published", "rendered", "skipped", "ns/snapshot");
+	for (long spins = 0; spins <= maxSpins; spins = spins ? spins * 10 : 200){
+		pthread_t writer, reader;
+		snapshotInit(&shared.snapshots);
+		pthread_mutex_init(&shared.lock, NULL);
+		shared.spins = spins;
+		shared.done = 0;
+		shared.torn = 0;
+		shared.backwards = 0;
+		double t0 = now();
+		pthread_create(&reader, NULL, readerThread, &shared);
+		pthread_create(&writer, NULL, writerThread, &shared);
+		pthread_join(writer, NULL);
+		double t1 = now();
+		pthread_join(reader, NULL);
+		pthread_mutex_destroy(&shared.lock);
+
+		const tetrisSnapshots *s = &shared.snapshots;
+		int ok = !shared.torn && !shared.backwards && s->published == (uint32_t)shared.count
+				&& s->rendered + s->skipped == s->published && s->taken == s->published;
+		printf("%8ld %10lu %10lu %10lu %12.1f%s\n", spins, (unsigned long)s->published, (unsigned long)s->rendered,
+				(unsigned long)s->skipped, (t1 - t0) / shared.count * 1e9, ok ? "" : "  MISMATCH");
+		if (shared.torn || shared.backwards)
+			printf("torn %ld, backwards %ld\n", shared.torn, shared.backwards);
+		failed |= !ok;
+	}
+	return failed;
+}
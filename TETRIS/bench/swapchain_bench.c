@@ -0,0 +1,186 @@
+/**
+ * Host test and benchmark of the triple buffered presentation in tetris_swapchain.
+ *
+ * Simulates the LTDC line by line with the timing of the STM32F429I-Discovery
+ * display: 328 lines per refresh, 320 of them scanned out, and the line
+ * interrupt at the first line after them, which switches to the newest frame
+ * presented some lines later as the interrupt latency. A renderer draws frames
+ * of random cost into the buffer it acquires, a row at a time, every row
+ * stamped with the number of the frame, and presents it when done. Every row
+ * scanned out is read from the buffer on the display.
+ *
+ * A scanned out frame of mixed stamps is torn, and must be counted by the
+ * swap chain as a switch after the end of the blank, which only happens when
+ * the interrupt is delayed on purpose. Frames must be shown in order, the
+ * renderer must never get the buffer on the display or the one waiting for it,
+ * and presented frames must be shown or dropped, otherwise the run reports a
+ * MISMATCH. The frames of the double buffering that waits for the line interrupt
+ * after every frame are reported for comparison, with the time of the presentation.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/swapchain_bench [refreshes] [seed]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tetris_random.h"
+#include "tetris_swapchain.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define frameLines 328 // Lines of a refresh, blank included
+#define firstActiveLine 4
+#define lastActiveLine 323
+#define blankLine 324 // Line interrupt, first line after the scanned out ones
+#define simRows (lastActiveLine - firstActiveLine + 1)
+
+struct scenario {
+	const char *name;
+	int minCost, maxCost; // Lines to draw a frame
+	int lateChance; // One line interrupt in lateChance comes after the blank, 0 for never
+};
+
+static const struct scenario scenarios[] = {
+	{"fast", 40, 120, 0},
+	{"matched", 250, 400, 0},
+	{"slow", 500, 900, 0},
+	{"mixed", 20, 1200, 0},
+	{"late irq", 100, 500, 16},
+};
+
+static uint32_t buffers[swapBuffers][simRows];
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Frames drawn and lines waited by the double buffering in the same time
+ */
+static long doubleBuffered(const struct scenario *s, tetrisRandom *random, long lines, long *waited){
+	long t = 0, frames = 0;
+	*waited = 0;
+	while (t < lines){
+		t += s->minCost + randomBelow(random, s->maxCost - s->minCost + 1);
+		long wait = (blankLine - t % frameLines + frameLines) % frameLines;
+		t += wait;
+		*waited += wait;
+		frames++;
+	}
+	return frames;
+}
+
+static int runScenario(const struct scenario *s, long refreshes, unsigned seed){
+	tetrisSwapChain chain;
+	tetrisRandom random;
+	long lines = refreshes * frameLines;
+	long interruptAt = -1, drawn = 0, progress = 0, cost = 0, rowsDone = 0;
+	long contentTorn = 0, backwards = 0, overlaps = 0;
+	uint32_t stamp = 0, scanStamp = 0, lastStamp = 0;
+	int scanMixed = 0, hardwareFront = 0, buffer = -1;
+
+	randomSeed(&random, seed);
+	swapInit(&chain);
+	for (int b = 0; b < swapBuffers; b++)
+		for (int r = 0; r < simRows; r++)
+			buffers[b][r] = 0;
+
+	for (long t = 0; t < lines; t++){
+		int line = (int)(t % frameLines);
+
+		// Scan out a row of the buffer on the display
+		if (line >= firstActiveLine && line <= lastActiveLine){
+			uint32_t value = buffers[hardwareFront][line - firstActiveLine];
+			if (line == firstActiveLine){
+				scanStamp = value;
+				scanMixed = 0;
+			}
+			else if (value != scanStamp)
+				scanMixed = 1;
+			if (line == lastActiveLine){
+				contentTorn += scanMixed;
+				backwards += !scanMixed && scanStamp < lastStamp;
+				if (!scanMixed)
+					lastStamp = scanStamp;
+			}
+		}
+
+		// Line interrupt switching the display
+		if (line == blankLine){
+			int latency = (int)randomBelow(&random, 3);
+			if (s->lateChance && randomBelow(&random, s->lateChance) == 0)
+				latency = 8 + (int)randomBelow(&random, 20);
+			interruptAt = t + latency;
+		}
+		if (t == interruptAt){
+			int next = swapVBlank(&chain);
+			if (next >= 0){
+				hardwareFront = next;
+				if (line >= firstActiveLine && line <= lastActiveLine)
+					chain.torn++;
+			}
+		}
+
+		// The renderer draws a row now and then, it never waits
+		if (buffer < 0){
+			buffer = swapAcquire(&chain);
+			overlaps += buffer == hardwareFront || buffer == chain.ready;
+			cost = s->minCost + randomBelow(&random, s->maxCost - s->minCost + 1);
+			stamp = (uint32_t)++drawn;
+			progress = 0;
+			rowsDone = 0;
+		}
+		progress++;
+		for (long rows = progress * simRows / cost; rowsDone < rows; rowsDone++)
+			buffers[buffer][rowsDone] = stamp;
+		if (progress == cost){
+			swapPresent(&chain);
+			buffer = -1;
+		}
+	}
+
+	long waited;
+	long doubleFrames = doubleBuffered(s, &random, lines, &waited);
+	int ok = contentTorn == (long)chain.torn && (s->lateChance || !chain.torn) && !backwards && !overlaps
+			&& chain.presented == chain.shown + chain.dropped + (chain.ready >= 0)
+			&& (long)chain.presented == drawn - (buffer >= 0);
+	printf("%-9s %7ld %7lu %7lu %7lu %5lu %9ld %7.1f%%%s\n", s->name, drawn, (unsigned long)chain.shown,
+			(unsigned long)chain.dropped, (unsigned long)chain.repeated, (unsigned long)chain.torn, doubleFrames,
+			100.0 * waited / lines, ok ? "" : "  MISMATCH");
+	if (!ok)
+		printf("torn by content %ld, backwards %ld, overlaps %ld\n", contentTorn, backwards, overlaps);
+	return !ok;
+}
+
+int main(int argc, char **argv){
+	long refreshes = argc > 1 ? atol(argv[1]) : 20000;
+	unsigned seed = argc > 2 ? (unsigned)atol(argv[2]) : 12345;
+	int failed = 0;
+
+	printf("%-9s %7s %7s %7s %7s %5s %9s %8s\n", "scenario", "drawn", "shown", "dropped", "repeat", "torn",
+			"double", "waiting");
+	for (size_t n = 0; n < sizeof(scenarios) / sizeof(scenarios[0]); n++)
+		failed |= runScenario(&scenarios[n], refreshes, seed + (unsigned)n);
+
+	// Time of the presentation path per frame
+	tetrisSwapChain chain;
+	volatile int sink = 0;
+	long num = 10000000;
+	swapInit(&chain);
+	double t0 = now();
+	for (long n = 0; n < num; n++){
+		sink += swapAcquire(&chain);
+		swapPresent(&chain);
+		if ((n & 3) == 0)
+			sink += swapVBlank(&chain);
+	}
+	double t1 = now();
+	printf("acquire and present: %.2f ns per frame\n", (t1 - t0) / num * 1e9);
+	return failed;
+}
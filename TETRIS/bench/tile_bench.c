@@ -0,0 +1,199 @@
+/**
+ * Host test and benchmark of the cell tiles in tetris_tiles and the blit
+ * batches in tetris_blit.
+ *
+ * The tiles of the colors of the board are checked against a golden hash of
+ * their pixels and at the pixels which make the bevel, in both layouts. Then
+ * random tiles, partly outside the screen, are queued by blitTile into a frame
+ * buffer in the turned orientation of the board and in the display
+ * orientation, and copied pixel by pixel into a reference. The software engine
+ * runs every batch at once. A second engine stands for the DMA2D: it keeps a
+ * copy of a batch and only runs it when the next one is started or the engine
+ * is waited for. After blitWait both must equal the reference, otherwise the
+ * run reports a MISMATCH. Reports the CPU time of a cell drawn by a fill and by
+ * the blit of its tile with the software engines, the cycles of the DMA2D are
+ * counted on the board and shown by K on the pause scene.
+ *
+ * Build and run on the host:
+ *   cmake -S core -B build && cmake --build build
+ *   ./build/tile_bench [tiles] [seed]
+ *
+ * @author: CHEN YUZONG
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tetris_blit.h"
+#include "tetris_fill.h"
+#include "tetris_random.h"
+#include "tetris_surface.h"
+#include "tetris_tiles.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define displayWidth 320
+#define displayHeight 240
+#define goldenHash 0x0dce1f2du // FNV-1a of the tiles of the board colors in display order
+
+// Colors of the cells on the board: empty, red, yellow, blue, orange
+static const uint16_t boardColors[renderCellColors] = {0xFFFF, 0xF800, 0xFFE0, 0x001F, 0xFD20};
+
+static uint16_t pixels[displayWidth * displayHeight], reference[displayWidth * displayHeight];
+
+static uint32_t nanoseconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+
+/*
+ * Engine of a batch in flight, run when the next one starts
+ */
+struct deferredQueue {
+	tetrisBlit pending[blitQueueLength];
+	int count;
+};
+
+static void deferredStart(void *context, const tetrisBlit *blits, int count){
+	struct deferredQueue *engine = context;
+	for (int n = 0; n < engine->count; n++)
+		blitRun(&engine->pending[n]);
+	memcpy(engine->pending, blits, sizeof(tetrisBlit) * count);
+	engine->count = count;
+}
+
+static void deferredWait(void *context){
+	struct deferredQueue *engine = context;
+	for (int n = 0; n < engine->count; n++)
+		blitRun(&engine->pending[n]);
+	engine->count = 0;
+}
+
+static int checkTiles(const tetrisTiles *tiles, const char *name){
+	uint32_t hash = 2166136261u;
+	int failed = 0;
+	for (int look = 0; look < tileLooks; look++)
+		for (int row = 0; row < tileSize; row++)
+			for (int col = 0; col < tileSize; col++){
+				uint16_t pixel = *surfacePixel(&tiles->surfaces[look], col, row);
+				hash = (hash ^ (pixel & 0xFF)) * 16777619u;
+				hash = (hash ^ (pixel >> 8)) * 16777619u;
+			}
+	for (int color = 0; color < renderCellColors; color++){
+		const tetrisSurface *tile = tilesLook(tiles, color), *outline = tilesLook(tiles, renderOutline | color);
+		uint16_t c = boardColors[color];
+		int last = tileSize - 1;
+		if (color){
+			failed |= *surfacePixel(tile, 0, 0) != tileBlend(c, 0xFFFF, 2);
+			failed |= *surfacePixel(tile, 1, 5) != tileBlend(c, 0xFFFF, 1);
+			failed |= *surfacePixel(tile, last, last) != tileBlend(c, 0x0000, 2);
+			failed |= *surfacePixel(tile, 5, last - 1) != tileBlend(c, 0x0000, 1);
+			failed |= *surfacePixel(tile, 0, last) != c || *surfacePixel(tile, last, 0) != c;
+		}
+		else
+			failed |= *surfacePixel(tile, 0, 0) != c || *surfacePixel(tile, last, last) != c;
+		failed |= *surfacePixel(tile, tileSize / 2, tileSize / 2) != c;
+		failed |= *surfacePixel(outline, 0, 3) != c || *surfacePixel(outline, last, 3) != c;
+		failed |= *surfacePixel(outline, tileSize / 2, tileSize / 2) != boardColors[0];
+	}
+	failed |= hash != goldenHash;
+	printf("tiles %-9s hash %08x%s\n", name, (unsigned)hash, failed ? "  MISMATCH" : "");
+	return failed;
+}
+
+static long runLayout(const char *name, int rotated, tetrisBlitQueue *queue, long count, unsigned seed){
+	tetrisSurface surface, referenceSurface;
+	tetrisTiles tiles;
+	tetrisRandom random;
+	long mismatches = 0;
+	if (rotated){
+		surfaceInitRotated(&surface, pixels, displayWidth, displayHeight);
+		surfaceInitRotated(&referenceSurface, reference, displayWidth, displayHeight);
+	}
+	else {
+		surfaceInit(&surface, pixels, displayWidth, displayHeight);
+		surfaceInit(&referenceSurface, reference, displayWidth, displayHeight);
+	}
+	tilesInit(&tiles, boardColors, rotated);
+	memset(pixels, 0, sizeof(pixels));
+	memset(reference, 0, sizeof(reference));
+	randomSeed(&random, seed);
+	for (long n = 0; n < count; n++){
+		int look = (int)randomBelow(&random, renderCellColors) | (randomBelow(&random, 4) == 0 ? renderOutline : 0);
+		int x = (int)randomBelow(&random, displayWidth + 2 * tileSize) - tileSize;
+		int y = (int)randomBelow(&random, displayHeight + 2 * tileSize) - tileSize;
+		const tetrisSurface *tile = tilesLook(&tiles, look);
+		blitTile(queue, &surface, x, y, tile);
+		for (int col = 0; col < tileSize; col++)
+			for (int row = 0; row < tileSize; row++)
+				if (x + col >= 0 && x + col < displayWidth && y + row >= 0 && y + row < displayHeight)
+					*surfacePixel(&referenceSurface, x + col, y + row) = *surfacePixel(tile, col, row);
+		if (randomBelow(&random, 200) == 0){ // The CPU reads the pixels
+			blitWait(queue);
+			mismatches += memcmp(pixels, reference, sizeof(pixels)) != 0;
+		}
+		else if (randomBelow(&random, 100) == 0)
+			blitFlush(queue);
+	}
+	blitWait(queue);
+	mismatches += memcmp(pixels, reference, sizeof(pixels)) != 0;
+	printf("%-9s %-9s %8lu %8lu %8ld%s\n", name, queue->start == deferredStart ? "deferred" : "software",
+			(unsigned long)queue->blitCount, (unsigned long)queue->batches, mismatches, mismatches ? "  MISMATCH" : "");
+	return mismatches;
+}
+
+int main(int argc, char **argv){
+	long count = argc > 1 ? atol(argv[1]) : 100000;
+	unsigned seed = argc > 2 ? (unsigned)atol(argv[2]) : 12345;
+	tetrisTiles tiles;
+	tetrisBlitQueue queue;
+	struct deferredQueue deferred;
+	long failed = 0;
+
+	tilesInit(&tiles, boardColors, 0);
+	failed += checkTiles(&tiles, "display");
+	tilesInit(&tiles, boardColors, 1);
+	failed += checkTiles(&tiles, "turned");
+
+	printf("%-9s %-9s %8s %8s %8s\n", "layout", "engine", "blits", "batches", "differ");
+	for (int rotated = 0; rotated <= 1; rotated++){
+		blitSoftwareInit(&queue);
+		failed += runLayout(rotated ? "turned" : "display", rotated, &queue, count, seed);
+		blitSoftwareInit(&queue);
+		deferred.count = 0;
+		queue.context = &deferred;
+		queue.start = deferredStart;
+		queue.wait = deferredWait;
+		failed += runLayout(rotated ? "turned" : "display", rotated, &queue, count, seed);
+	}
+
+	// CPU time of a playfield of cells by the software engines, the whole fill or blit
+	tetrisSurface surface;
+	tetrisFillEngine fill;
+	surfaceInitRotated(&surface, pixels, displayWidth, displayHeight);
+	fillSoftwareInit(&fill);
+	blitSoftwareInit(&queue);
+	fill.clock = queue.clock = nanoseconds;
+	double fillBest = 1e18, blitBest = 1e18;
+	int repeats = 2000, cells = 200;
+	for (int run = 0; run < 3; run++){
+		fill.busy = queue.busy = 0;
+		for (int n = 0; n < repeats; n++)
+			for (int cell = 0; cell < cells; cell++)
+				fillRect(&fill, &surface, 110 + 11 * (cell % 10), 10 + 11 * (cell / 10), tileSize, tileSize, boardColors[cell % 5]);
+		for (int n = 0; n < repeats; n++){
+			for (int cell = 0; cell < cells; cell++)
+				blitTile(&queue, &surface, 110 + 11 * (cell % 10), 10 + 11 * (cell / 10), tilesLook(&tiles, cell % 5));
+			blitWait(&queue);
+		}
+		if ((double)fill.busy / repeats / cells < fillBest)
+			fillBest = (double)fill.busy / repeats / cells;
+		if ((double)queue.busy / repeats / cells < blitBest)
+			blitBest = (double)queue.busy / repeats / cells;
+	}
+	printf("software cell: fill %.1f ns, tile blit %.1f ns, %.0f batches and 1 wait a playfield of %d cells\n",
+			fillBest, blitBest, (double)queue.batches / 3 / repeats, cells);
+	return failed != 0;
+}
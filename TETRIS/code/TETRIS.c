@@ -10,94 +10,70 @@
 #include "task.h"
 #include "queue.h"
 #include "timers.h"
+#include "tetris_board.h"
+#include "tetris_shape.h"
+#include "tetris_game.h"
+#include "tetris_shift.h"
+#include "tetris_snapshot.h"
+#include "tetris_render.h"
+#include "tetris_atlas.h"
+#include "tetris_tiles.h"
+#include "tetris_blit.h"
+#include "gravity_timer.h"
+#include "input_queue.h"
+#include "button_exti.h"
+#include "joystick_dma.h"
+#include "fill_dma2d.h"
+#include "latency_trace.h"
 #include <time.h>
 #include <stdlib.h>
 
-#define levelNum 4
-#define maxLineDisappear 4
-// Set longer round time for double mode than single mode due to higher difficulty
-#define singleModeSpeed 400
-#define doubleModeSpeed 600
-
 QueueHandle_t ESPL_RxQueue; // Already defined in ESPL_Functions.h
 SemaphoreHandle_t ESPL_DisplayReady;
-SemaphoreHandle_t inputReceived; // Binary semaphore
+QueueHandle_t buddyEvents; // Events of buddy's board waiting to be replayed in double mode
+SemaphoreHandle_t frameChanged; // Given by every snapshot published for the render task
 
 /*----------------------------------------Global Variable----------------------------------------*/
-// Start and stop bytes for the UART protocol
-static const uint8_t startByte = 0xAA, stopByte = 0x55;
+// Start and stop bytes for the UART protocol, the start byte tells the data package from the seed package
+static const uint8_t startByte = 0xAA, seedStartByte = 0xA5, stopByte = 0x55;
+static const uint8_t dataLength = 9, seedLength = 7; // Package lengths in bytes
+static const int seedFrames = 50; // Announce the seed of a new game in 50 frames to cover lost packages
 static const uint16_t displaySizeX = 320, displaySizeY = 240;
-int globalSpeed = 400;
-int scr = 0, lvl = 0, lin = 0;
-int roundTime = 100; // Default refreshing time
-int isGameOver;
 int connected = 0; // Not connected by defaut
 int myState = -1, buddyState = -1; // Record game states of 2 connected boards, in single mode by default
-int buddyA = 0, buddyB = 0, buddyC = 0, buddyD = 0, buddyE = 0; // Secure inputs of buddy's board
 int buddyAState = 1, buddyBState = 1, buddyCState = 1, buddyDState = 1, buddyEState = 1; // Instantaneous inputs of budd's board
-int currentX = 0, currentY = 0, currentType = 0, currentColor = 0, nextType = 0, nextColor = 0; // Pass tetris parameters to buddy's board
-int buddyCurrentX = 0, buddyCurrentY = 0, buddyCurrentType = 0, buddyCurrentColor = 0, buddyNextType = 0, buddyNextColor = 0;
-static const int arrHeight = 20, arrWidth = 10; // Array of the block map
-int score_add[maxLineDisappear][levelNum] = {40, 80, 120, 160, 100, 200, 300, 400, 300, 600, 900, 1200, 1200, 2500, 3600, 4800}; // Score setting rule
+// In double mode the rotating board runs the game: it sends the seed of the game and every event it applies,
+// and the moving board replays them on its own game with the same tetris sequence
+int linkSeedFrames = 0; // Frames left to announce the seed
+#define linkGravityFrame 7 // Event of a gravity frame, the other events are buttons
+uint8_t linkEvents[256]; // Log of the applied events, numbered modulo 256
+uint8_t linkEventCount = 0;
+uint32_t buddySeed = 0;
+int buddySeedReady = 0; // A new seed is received and the game is not started with it yet
+uint8_t buddyEventCount = 0; // Events of buddy's board put into the queue
+int linkDesync = 0; // Events of buddy's board are lost, the games differ
+// Auto shift of the held move buttons in frames, a repeat of 0 moves to the wall in single mode
+int shiftDelay = shiftDelayFrames, shiftRepeat = shiftRepeatFrames;
+int shiftFrames = 0; // Frames of the gravity timer passed during the game and not shifted yet
 /*----------------------------------------END Global Variable----------------------------------------*/
 
-/*----------------------------------------enum, struct----------------------------------------*/
-enum currentState{ // Game state types
-	gameMenu,
-	select,
-	initGame,
-	inGame,
-	nextRound,
-	gamePause,
-	gameOver
-};
-
-enum currentMode{ // Game mode types
-	modeSelect, // Select game parameters on the main menu
-	singlePlayer,
-	doublePlayerSelect,
-	doublePlayerRotate,
-	doublePlayerMove
-};
-
-enum button{ // User input types
-	A,
-	B,
-	C,
-	D,
-	E,
-	system_refresh // Condition without pressing of any button
-};
-
-enum direction{ // Tetris directions of movement
-	down,
-	left,
-	right
-};
-
-struct tetrisBlock { // Tetris parameters
-	point center; // Central coordinate of the tetris for rotation
-	point position[4]; // Positions containing the coordinates of 4 squares
-	int type;
-	int next_type;
-	int color_num;
-};
-/*----------------------------------------END enum, struct----------------------------------------*/
-
-/*----------------------------------------typedef enum, struct----------------------------------------*/
-typedef enum currentState currentState;
-typedef enum currentMode currentMode;
-typedef enum button button;
-typedef enum direction direction;
-typedef struct tetrisBlock tetrisBlock;
-/*----------------------------------------END typedef enum, struct----------------------------------------*/
-
 /*----------------------------------------Global enum, struct Variable----------------------------------------*/
 currentState state, receivedState;
-currentMode mode = modeSelect;
-button publicButton = B, privateButton; // Set public and private receivers to secure the button inputs
+tetrisGame game = {.speed = singleModeSpeed}; // Board, tetris blocks and settings of the running game
+tetrisShift shiftSide, shiftDown; // Left and right by B and D, down by C
+tetrisSnapshots snapshots; // What the game task published to draw, the render task draws the newest
 direction direct;
-color_t color[5] = {White, Red, Yellow, Blue, Orange}; // Randomize the tetris color
+// Logical colors of the game scene, the tetris colors last with color 0 for the empty cells
+color_t sceneColors[renderColors] = {Green, White, Black, Red, White, Red, Yellow, Blue, Orange};
+renderShadow sceneShadows[swapBuffers]; // Game scene last drawn into every frame buffer
+uint32_t sceneFrames = 0, sceneCalls = 0; // Game scenes drawn and their fills, boxes and strings
+font_t fontText, fontTitle, fontSmall; // Fonts of the scenes, opened once by the render task
+tetrisAtlas sceneAtlas; // Glyphs of the panel numbers and labels, in SDRAM after the frame buffers
+#define sceneAtlasStride 1024 // Pixels of a row of the atlas
+#define sceneHudBuffer ESPL_FrameBuffer(swapBuffers + 1) // Static layer of the game scene, after the atlas
+int sceneHudMode = -1; // Mode of the game the static layer is drawn for, -1 before the first game
+tetrisTiles sceneTiles; // Bevelled cells of the tetris colors, turned like the frame buffers
+tetrisBlitQueue sceneBlits; // Tiles of the cells drawn, started as a batch before anything else is drawn
 /*----------------------------------------END Global enum, struct Variable----------------------------------------*/
 
 /*----------------------------------------Task Prototypes----------------------------------------*/
@@ -106,67 +82,63 @@ void buttonInput();
 void sendToBuddy();
 void receiveData();
 void gameStateManagement();
+void renderFrames();
 /*----------------------------------------END Task Prototypes----------------------------------------*/
 
 /*----------------------------------------Function Prototypes----------------------------------------*/
 // Transimit data between 2 connected boards
 void sendData();
-void tetrisSynchronization(tetrisBlock *currentTetris, tetrisBlock *nextTetris);
+void linkEvent(uint8_t event);
+int linkReplay();
 
-// Initialize system settings
-void initBuddyBut();
-void systemInit();
-void initGameSetting(tetrisBlock *currentTetris, tetrisBlock *nextTetris, int map[arrHeight][arrWidth]);
+// Select the local buttons of the game mode
+int localButtonEnabled(button privateButton);
 
-// Manage game state
-currentState getState(currentState state, button privateButton);
+// Auto shift of the held move buttons
+int buttonHeld(button privateButton);
+int shiftHeldButtons();
+int checkJoystick(int frames);
 
-// Check tetris conditions to trigger next operation
-int checkNewTetris(tetrisBlock *tetrisPtr, int map[arrHeight][arrWidth]);
-int checkFullLine(int fullLineNumber[5], int map[arrHeight][arrWidth]);
-void letLineDisappear(int fullLineNumber[5], int num, int map[arrHeight][arrWidth]);
-int checkGameOver(tetrisBlock *blockPtr);
-
-// Modify the fixed block map
-void clearMap(int map[arrHeight][arrWidth]);
-void clearTetrisPosition(tetrisBlock* blockPtr, int map[arrHeight][arrWidth]);
-void printTetrisOnMap(tetrisBlock *blockPtr, int map[arrHeight][arrWidth]);
-
-// Check tetris positions relative to the fixed block map
-int getLeft(tetrisBlock* blockPtr);
-int getRight(tetrisBlock* blockPtr);
-int noCollision(tetrisBlock* blockPtr, int map[arrHeight][arrWidth]);
+// Initialize system settings
+void systemInit();
+void initGameSetting();
 
-// Generate tetris blocks
-void copyTetris(tetrisBlock *currentTetris, tetrisBlock *nextTetris);
-void sendTetris(tetrisBlock* currentTetris, tetrisBlock* nextTetris);
-void tetrisInit(tetrisBlock* blockPtr);
-void tetrisShape(tetrisBlock* blockPtr);
+// Publish the game for the render task
+void publishFrame(currentState frameState, int page);
 
-// Tetris operations
-int tetrisMove(tetrisBlock* blockPtr, direction direct, int map[arrHeight][arrWidth]);
-void tetrisRotate(tetrisBlock* blockPtr, int map[arrHeight][arrWidth]);
+// Open the fonts and capture the glyph atlas
+void fontsInit();
 
 // Draw game interface
-void drawGameMenu();
-void drawSelectMode(int selected);
-void drawGameEnvironment(tetrisBlock* nextTetris, int map[arrHeight][arrWidth]);
-void drawPause();
-void drawGameOver();
+void drawSnapshot(const tetrisSnapshot *snapshot);
+void drawGameMenu(const tetrisSnapshot *snapshot);
+void drawSelectMode(const tetrisSnapshot *snapshot);
+void drawGameEnvironment(const tetrisSnapshot *snapshot);
+void drawHud(currentMode mode);
+void drawPause(const tetrisSnapshot *snapshot);
+void drawLatency();
+void drawGameOver(const tetrisSnapshot *snapshot);
 /*----------------------------------------END Function Prototypes----------------------------------------*/
 
 
 int main() {
 	// Initialize Board functions and graphics
 	ESPL_SystemInit();
+	fillDma2dInit(&ESPL_FillEngine, &sceneBlits);
 
-	inputReceived = xSemaphoreCreateBinary();
+	inputInit();
+	latencyTraceInit();
+	snapshotInit(&snapshots);
+	frameChanged = xSemaphoreCreateBinary();
+	joystickInit();
+	buddyEvents = xQueueCreate(32, sizeof(uint8_t));
 
 	xTaskCreate(refreshSystem, "refreshSystem", 2000, NULL, 3, NULL); // Task to refresh the system for each game round
-	xTaskCreate(buttonInput, "buttonInput", 2000, NULL, 2, NULL); // Task to get button inputs from the user
-	xTaskCreate(gameStateManagement, "gameStateManagement", 2000, NULL, 2, NULL); // Task to manage game states
+	xTaskCreate(buttonInput, "buttonInput", 2000, NULL, 2, NULL); // Task to get button inputs of buddy's board
+	xTaskCreate(gameStateManagement, "gameStateManagement", 2000, NULL, 3, NULL); // Task to manage game states, preempts the others as soon as an input arrives
 	xTaskCreate(receiveData, "receiveData", 1000, NULL, 2, NULL); // Task to receive inputs and data from buddy's board
 	xTaskCreate(sendToBuddy, "sendToBuddy", 1000, NULL, 2, NULL); // Task to send inputs and data to buddy's board
+	xTaskCreate(renderFrames, "renderFrames", 2000, NULL, 1, NULL); // Task to draw the newest game state, runs when the others wait
 
 	// Start FreeRTOS Scheduler
 	vTaskStartScheduler();
@@ -175,163 +147,95 @@ int main() {
 
 /*----------------------------------------Task Definition----------------------------------------*/
 /*
- * Task function to refresh the system for each round
+ * Task function to refresh the system for each frame of the gravity timer
  */
 void refreshSystem() {
-	TickType_t xLastWakeTime;
-	xLastWakeTime = xTaskGetTickCount();
+	gravityTimerInit();
 	while (TRUE) {
-		srand(xTaskGetTickCount()); // Get random seed from random generator with kernel tick
-		publicButton = system_refresh; // Nothing pressed
-		xSemaphoreGive(inputReceived); // Give semaphore to task manager
-		roundTime = globalSpeed/(lvl+1); // Automatically set descending speed of tetris according to level
-		vTaskDelayUntil(&xLastWakeTime, roundTime);
+		xSemaphoreTake(frameReady, portMAX_DELAY); // Given by the gravity timer once per frame
+		if (uxQueueMessagesWaiting(inputEvents) == 0) // A waiting event hands the frames to the game as well
+			inputPost(system_refresh, inputTimer); // Nothing pressed
 	}
 }
 
 /*
- * Task function to get button inputs from the user
+ * Task function to get button inputs of buddy's board and check the connection,
+ * the local buttons come from their interrupts
  */
 void buttonInput() {
+	buttonInit();
 	TickType_t xLastWakeTime;
 	xLastWakeTime = xTaskGetTickCount();
-	const TickType_t tickFramerate = 20; // Set the frame rate of getting button inputs
+	const TickType_t tickFramerate = 20; // Set the frame rate of getting button inputs of buddy's board
 
-    // Record previous button values for debounce
+	// Record previous button values of buddy's board for debounce
 	int buddyPressedA = 1, buddyPressedB = 1, buddyPressedC = 1, buddyPressedD = 1, buddyPressedE = 1;
-	int pressedA = 1, pressedB = 1, pressedC = 1, pressedD = 1, pressedE = 1;
 	int roundNum = 0, connectionErrorTime = 0; // Variables for checking UART connection
 
 	while(TRUE) {
-		// Receive local button A input
-		if (mode == modeSelect || mode == singlePlayer || mode == doublePlayerRotate || mode == doublePlayerSelect) {
-			if (GPIO_ReadInputDataBit(ESPL_Register_Button_A, ESPL_Pin_Button_A)
-					== 0 && pressedA == 1) {
-				publicButton = A;
-				xSemaphoreGive(inputReceived);
-				pressedA = 0;
-			} else if (GPIO_ReadInputDataBit(ESPL_Register_Button_A, ESPL_Pin_Button_A) == 1)
-				pressedA = 1;
-		}
 		// Receive external button A input
-		if (mode == doublePlayerMove || mode == doublePlayerSelect || mode == modeSelect
-				|| (myState == (int)gamePause && mode == doublePlayerRotate)) {
+		if (game.mode == doublePlayerMove || game.mode == doublePlayerSelect || game.mode == modeSelect
+				|| (myState == (int)gamePause && game.mode == doublePlayerRotate)) {
 			if (buddyAState == 0 && buddyPressedA == 1) {
-				publicButton = A;
-				buddyA = 1;
-				xSemaphoreGive(inputReceived);
+				inputPost(A, inputBuddy);
 				buddyPressedA = 0;
 			} else if (buddyAState == 1) {
 				buddyPressedA = 1;
 			}
 		}
-		// Receive local button B input
-		if (mode == singlePlayer || mode == doublePlayerMove || mode == doublePlayerSelect || mode == modeSelect
-				|| (mode == doublePlayerRotate && myState == (int)gamePause)) {
-			if (GPIO_ReadInputDataBit(ESPL_Register_Button_B, ESPL_Pin_Button_B)
-					== 0 && pressedB == 1) {
-				publicButton = B;
-				xSemaphoreGive(inputReceived);
-				pressedB = 0;
-			} else if (GPIO_ReadInputDataBit(ESPL_Register_Button_B, ESPL_Pin_Button_B) == 1)
-				pressedB = 1;
-		}
 		// Receive external button B input
-		if (mode == doublePlayerRotate || mode == doublePlayerSelect || mode == modeSelect) {
+		if (game.mode == doublePlayerRotate || game.mode == doublePlayerSelect || game.mode == modeSelect) {
 			if (buddyBState == 0 && buddyPressedB == 1) {
-				publicButton = B;
-				buddyB = 1;
-				xSemaphoreGive(inputReceived);
+				inputPost(B, inputBuddy);
 				buddyPressedB = 0;
 			} else if (buddyBState == 1) {
 				buddyPressedB = 1;
 			}
 		}
-		// Receive local button C input
-		if (mode == singlePlayer || mode == doublePlayerMove || mode == doublePlayerSelect || mode == modeSelect) {
-			if (GPIO_ReadInputDataBit(ESPL_Register_Button_C, ESPL_Pin_Button_C)
-					== 0 && pressedC == 1){
-				publicButton = C;
-				xSemaphoreGive(inputReceived);
-				pressedC = 0;
-			} else if (GPIO_ReadInputDataBit(ESPL_Register_Button_C, ESPL_Pin_Button_C) == 1)
-				pressedC = 1;
-		}
 		// Receive external button C input
-		if (mode == doublePlayerRotate || mode == doublePlayerSelect || mode == modeSelect) {
+		if (game.mode == doublePlayerRotate || game.mode == doublePlayerSelect || game.mode == modeSelect) {
 			if (buddyCState == 0 && buddyPressedC == 1) {
-				publicButton = C;
-				buddyC = 1;
-				xSemaphoreGive(inputReceived);
+				inputPost(C, inputBuddy);
 				buddyPressedC = 0;
 			} else if (buddyCState == 1) {
 				buddyPressedC = 1;
 			}
 		}
-        // Receive local button D input
-		if (mode == singlePlayer || mode == doublePlayerMove || mode == doublePlayerSelect || mode == modeSelect
-				|| (mode == doublePlayerRotate && myState == (int)gamePause)) {
-			if (GPIO_ReadInputDataBit(ESPL_Register_Button_D, ESPL_Pin_Button_D)
-					== 0 && pressedD == 1) {
-				publicButton = D;
-				xSemaphoreGive(inputReceived);
-				pressedD = 0;
-			} else if (GPIO_ReadInputDataBit(ESPL_Register_Button_D, ESPL_Pin_Button_D) == 1)
-				pressedD = 1;
-		}
 		// Receive external button D input
-		if (mode == doublePlayerRotate || mode == doublePlayerSelect || mode == modeSelect) {
+		if (game.mode == doublePlayerRotate || game.mode == doublePlayerSelect || game.mode == modeSelect) {
 			if (buddyDState == 0 && buddyPressedD == 1) {
-				publicButton = D;
-				buddyD = 1;
-				xSemaphoreGive(inputReceived);
+				inputPost(D, inputBuddy);
 				buddyPressedD = 0;
 			} else if (buddyDState == 1) {
 				buddyPressedD = 1;
 			}
 		}
-        // Receive local button E input
-		if (mode == singlePlayer || mode == doublePlayerRotate) {
-			if (GPIO_ReadInputDataBit(ESPL_Register_Button_E, ESPL_Pin_Button_E)
-					== 0 && pressedE == 1){
-				publicButton = E;
-				xSemaphoreGive(inputReceived);
-				pressedE = 0;
-			} else if (GPIO_ReadInputDataBit(ESPL_Register_Button_E, ESPL_Pin_Button_E) == 1)
-				pressedE = 1;
-		}
         // Receive external button E input
-		if (mode == doublePlayerRotate) {
+		if (game.mode == doublePlayerRotate) {
 			if (buddyEState == 0 && buddyPressedE == 1) {
-				publicButton = E;
-				buddyE = 1;
-				xSemaphoreGive(inputReceived);
+				inputPost(E, inputBuddy);
 				buddyPressedE = 0;
 			} else if (buddyEState == 1) {
 				buddyPressedE = 1;
 			}
 		}
 		// Receive button E input for pause in double mode
-		if (mode == doublePlayerMove && buddyState == (int)gamePause){
-			publicButton = E;
-			xSemaphoreGive(inputReceived);
+		if (game.mode == doublePlayerMove && buddyState == (int)gamePause && myState != (int)gamePause){
+			inputPost(E, inputLink);
 		}
 		// Receive button ABD input for pause in double mode
-		if (mode == doublePlayerMove && myState == (int)gamePause){
+		if (game.mode == doublePlayerMove && myState == (int)gamePause){
 			if (buddyState == (int)gameOver)
 			{
-				publicButton = B;
-				xSemaphoreGive(inputReceived);
+				inputPost(B, inputLink);
 			}
 			if (buddyState == (int)initGame)
 			{
-				publicButton = A;
-				xSemaphoreGive(inputReceived);
+				inputPost(A, inputLink);
 			}
 			if (buddyState == (int)nextRound || buddyState == (int)inGame)
 			{
-				publicButton = D;
-				xSemaphoreGive(inputReceived);
+				inputPost(D, inputLink);
 			}
 
 		}
@@ -371,56 +275,69 @@ void sendToBuddy() {
  */
 void receiveData() {
 	char input;
-	uint8_t pos = 0;
-	char checkxor1, checkxor2;
-	int buddySysrefresh;
-	char buffer[16]; // Start byte, buddy A button state, checksign (copy of data), End byte
+	uint8_t pos = 0, length = 0;
+	uint8_t buffer[9]; // Start byte, data, checksum (xor of data), stop byte
 	while (TRUE) {
 		// Wait for data in queue
 		xQueueReceive(ESPL_RxQueue, &input, portMAX_DELAY);
 
-		// Decode package by buffer position
-		switch (pos) {
-		case 0: // Start byte
-			if (input != startByte)
-				break;
-		case 1:
-		case 2:
-		case 3:
-		case 4:
-		case 5:
-		case 6:
-		case 7:
-		case 8:
-		case 9:
-		case 10:
-		case 11:
-		case 12:
-		case 13:
-		case 14:
-			// Read received data in buffer
-			buffer[pos] = input;
-			pos++;
-			break;
-		case 15: // End byte
-			// Check if package is corrupted
-			checkxor1 = buffer[7];
-			checkxor2 = buffer[8];
-			if (input == stopByte && (checkxor1 == buffer[1] ^ buffer[2]) && (checkxor2 == buffer[3] ^ buffer[4])) {
-				buddyAState = buffer[1];
-				buddyBState = buffer[2];
-				buddyCState = buffer[3];
-				buddyDState = buffer[4];
-				buddyEState = buffer[5];
-				buddyState = buffer[6];
-				buddyCurrentX = buffer[9];
-				buddyCurrentY = buffer[10];
-				buddyCurrentType = buffer[11];
-				buddyCurrentColor = buffer[12];
-				buddyNextType = buffer[13];
-				buddyNextColor = buffer[14];
+		// The start byte gives the length of the package
+		if (pos == 0) {
+			if ((uint8_t)input == startByte)
+				length = dataLength;
+			else if ((uint8_t)input == seedStartByte)
+				length = seedLength;
+			else
+				continue;
+		}
+		buffer[pos] = input;
+		pos++;
+		if (pos < length)
+			continue;
+		pos = 0;
+
+		// Check if package is corrupted
+		uint8_t checkxor = 0;
+		for (int n = 1; n < length - 2; n++)
+			checkxor ^= buffer[n];
+		if (buffer[length - 1] != stopByte || buffer[length - 2] != checkxor)
+			continue;
+
+		if (buffer[0] == seedStartByte) {
+			uint32_t seed = buffer[1] | buffer[2] << 8 | buffer[3] << 16 | (uint32_t)buffer[4] << 24;
+			if (seed != buddySeed) { // New game, its events are numbered from 0
+				xQueueReset(buddyEvents);
+				buddyEventCount = 0;
+				linkDesync = 0;
+				buddySeed = seed;
+				buddySeedReady = 1;
+			}
+			continue;
+		}
+
+		buddyAState = buffer[1] & 1;
+		buddyBState = buffer[1] >> 1 & 1;
+		buddyCState = buffer[1] >> 2 & 1;
+		buddyDState = buffer[1] >> 3 & 1;
+		buddyEState = buffer[1] >> 4 & 1;
+		buddyState = (int8_t)buffer[2];
+		// Queue the events missed so far, the package repeats the last 8 events
+		uint32_t events = buffer[4] | buffer[5] << 8 | buffer[6] << 16;
+		uint8_t missing = buffer[3] - buddyEventCount;
+		if (missing > 8) {
+			linkDesync = 1;
+			missing = 0;
+		}
+		buddyEventCount = buffer[3];
+		if (missing) {
+			while (missing) {
+				missing--;
+				uint8_t event = events >> (3 * missing) & 7;
+				if (xQueueSend(buddyEvents, &event, 0) != pdTRUE)
+					linkDesync = 1;
 			}
-			pos = 0;
+			if (game.mode == doublePlayerMove) // Replay them right away
+				inputPost(system_refresh, inputLink);
 		}
 	}
 }
@@ -430,1078 +347,586 @@ void receiveData() {
  */
 void gameStateManagement() {
 	currentState state = gameMenu; // Start with the main menu
-	int map[arrHeight][arrWidth];
-
-	tetrisBlock block1;
-	tetrisBlock block2;
-	tetrisBlock *currentTetris = &block1;
-	tetrisBlock *nextTetris = &block2;
+	tetrisBoard *board = &game.board;
+	tetrisBlock *currentTetris = &game.current;
+	uint32_t lastFrames = gravityFrames;
+	int frames = 0; // Frames of the gravity timer passed during the game and not fallen yet
 
 	systemInit();
-	drawGameMenu();
+	publishFrame(state, snapshotPause);
 
 	while(TRUE){
-		if ((xSemaphoreTake(inputReceived, portMAX_DELAY == pdTRUE))){
-			button privateButton = publicButton;
-			state = getState(state, privateButton);
+		inputEvent event;
+		if (xQueueReceive(inputEvents, &event, portMAX_DELAY) == pdTRUE){
+			button privateButton = (button)event.button;
+			inputMeasure(&event);
+			if (event.source == inputLocal && !localButtonEnabled(privateButton))
+				continue; // The button belongs to buddy's board in this mode
+			latencyTaken(&event, snapshots.published + 1); // Shown from the next snapshot on
+			currentState lastState = state;
+			uint32_t frameCount = gravityFrames;
+			if (state == inGame || state == nextRound){
+				frames += frameCount - lastFrames;
+				shiftFrames += frameCount - lastFrames;
+			}
+			lastFrames = frameCount;
+			game.connected = connected && !linkDesync; // Secure the inputs of buddy's board for the state machine
+			game.buddyA = event.source == inputBuddy && privateButton == A;
+			game.buddyC = event.source == inputBuddy && privateButton == C;
+			state = getState(&game, state, privateButton);
+			if (state == gameMenu && lastState != gameMenu)
+				systemInit(); // Back to the main menu
 			myState = (int)state;
-			initBuddyBut();
 
 			switch(state){
-			case gameMenu:{ // Display the main menu
-				drawGameMenu();
-				break;
-			}
-			case select: { // Select game parameters
-				drawSelectMode(1);
+			case gameMenu: // Display the main menu
+			case selectMenu:{ // Select game parameters
+				publishFrame(state, snapshotPause);
 				break;
 			}
 			case initGame:{ // Initialize the game
-				initGameSetting(currentTetris, nextTetris, map);
-				drawGameEnvironment(nextTetris, map);
+				initGameSetting();
+				frames = 0;
+				shiftFrames = 0;
+				publishFrame(state, snapshotPause);
 				break;
 			}
-			case inGame:{ // During the game
-				clearTetrisPosition(currentTetris, map);
-				switch(privateButton){
-				case A:{ // Rotate counterclockwise
-					tetrisRotate(currentTetris, map);
-					break;
-				}
-				case B:{ // Move right
-					tetrisMove(currentTetris, right, map);
-					break;
-				}
-				case C:{ // Move down
-					tetrisMove(currentTetris, down, map);
+			case inGame:{ // During the game, the falling tetris is drawn over the fixed block map
+				if (game.mode == doublePlayerMove){ // Buddy's board applies the inputs of both boards
+					if (linkReplay())
+						publishFrame(state, snapshotPause);
 					break;
 				}
-				case D:{ // Move left
-					tetrisMove(currentTetris, left, map);
+				if (privateButton == system_refresh){ // Frame without any input, the tetris falls in the next round
+					if (shiftHeldButtons())
+						publishFrame(state, snapshotPause);
 					break;
 				}
-				}
-				sendTetris(currentTetris, nextTetris);
-				printTetrisOnMap(currentTetris, map);
-				drawGameEnvironment(nextTetris, map);
+				gameInput(&game, privateButton); // Move and rotate the falling tetris
+				if (game.mode == doublePlayerRotate && privateButton <= D)
+					linkEvent(privateButton);
+				if (privateButton == B || privateButton == D) // Held down they repeat after the delay
+					shiftPress(&shiftSide, privateButton);
+				else if (privateButton == C)
+					shiftPress(&shiftDown, privateButton);
+				publishFrame(state, snapshotPause);
 				break;
 			}
 			case nextRound:{
-				int isNewTetris = 0;
-				clearTetrisPosition(currentTetris, map);
-				if (mode == doublePlayerMove){ // In double mode
-					int connectionBreakCount = 0;
-					while(buddyCurrentY == currentTetris->center.y && buddyCurrentX == currentTetris->center.x
-							&& buddyCurrentType == currentTetris->type) {
-						if (connectionBreakCount > 200)
-							break;
-						connectionBreakCount++;
-						vTaskDelay(5);
-					}
-					tetrisSynchronization(currentTetris, nextTetris);
-					tetrisBlock temp;
-					copyTetris(&temp, currentTetris);
-					isNewTetris = checkNewTetris(&temp, map);
+				if (game.mode == doublePlayerMove){ // In double mode the rounds of buddy's board are replayed
+					if (linkReplay())
+						publishFrame(state, snapshotPause);
+					break;
 				}
-				else{ // In single mode
-					isNewTetris = checkNewTetris(currentTetris, map); //Check if the tetris falls to the end and try to drop it 1 block down
-					sendTetris(currentTetris, nextTetris);
+				uint32_t lockedRows = 0; // Only the rows of the fixed tetris can become full
+				int rows = 0, isNewTetris = 0;
+				int shifted = shiftHeldButtons(); // All moves of the frames are drawn at once
+				if (privateButton == K){ // Hard drop, the tetris is fixed right below
+					tetrisDrop(currentTetris, board);
+					isNewTetris = 1;
 				}
-				printTetrisOnMap(currentTetris, map); //Print the fixed position of current tetris on map
-				drawGameEnvironment(nextTetris, map);
-				if (isNewTetris) {
-					isGameOver = checkGameOver(currentTetris); //Check if game is over
-					if (mode == doublePlayerMove) {
-						int connectionBreakCount = 0;
-						while(buddyCurrentY == currentTetris->center.y || !isNewTetris) {
-							if (connectionBreakCount > 200)
-								break;
-							connectionBreakCount++;
-							if (buddyCurrentX != currentTetris->center.x || buddyCurrentType != currentTetris->type || !isNewTetris){
-								clearTetrisPosition(currentTetris, map);
-								tetrisSynchronization(currentTetris, nextTetris);
-								tetrisBlock temp;
-								copyTetris(&temp, currentTetris);
-								isNewTetris = checkNewTetris(&temp, map);
-								printTetrisOnMap(currentTetris, map); //Print the fixed position of current tetris on map
-								drawGameEnvironment(nextTetris, map);
-							}
-							vTaskDelay(5);
-						}
-						tetrisSynchronization(currentTetris, nextTetris);
-					}
-					else{
-						copyTetris(currentTetris, nextTetris); //Change current tetris to next tetris and generate a new next tetris
-						tetrisInit(nextTetris);
-						sendTetris(currentTetris, nextTetris);
-					}
+				while (frames > 0 && !isNewTetris){ // Let the tetris fall frame by frame, it is fixed after the lock delay
+					frames--;
+					isNewTetris = gameGravity(&game, 1, &rows);
+					if (game.mode == doublePlayerRotate)
+						linkEvent(linkGravityFrame);
 				}
+				frames = 0;
+				if (!rows && !isNewTetris && !shifted)
+					break; // Nothing changed to draw
 				if (isNewTetris){
-					int fullLineNumber[5];
-					int noOfFullLine = checkFullLine(fullLineNumber, map);
+					if (game.mode == doublePlayerRotate)
+						linkEvent(system_refresh);
+					lockedRows = gameLockTetris(&game); //Print the fixed position of current tetris on map and check if game is over
+					gameNextTetris(&game); //Change current tetris to next tetris and generate a new next tetris
+					uint32_t fullLines = checkFullLine(lockedRows, board);
+					int noOfFullLine = boardRowCount(fullLines);
 					if (noOfFullLine){ // Refresh the game condition
-						scr += score_add[noOfFullLine-1][lvl];
-						lin += noOfFullLine;
-						lvl = lvl + lin/5; // Automatic increase of level
-						if (lvl > 3)
-							lvl = 3;
-						drawGameEnvironment(nextTetris, map);
-						letLineDisappear(fullLineNumber, noOfFullLine, map);
-						drawGameEnvironment(nextTetris, map);
+						gameAddLines(&game, noOfFullLine);
+						letLineDisappear(fullLines, board);
 					}
 				}
+				publishFrame(state, snapshotPause); // Drawn once with all changes of the round
 				break;
 			}
-			case gamePause:{
-				drawPause();
+			case gamePause:{ // K dumps the latency histograms on demand
+				publishFrame(state, privateButton == K ? snapshotLatency : snapshotPause);
 				break;
 			}
 			case gameOver:{
-				drawGameOver();
+				publishFrame(state, snapshotPause);
 				break;
 			}
 			}
 		}
 	}
-	initBuddyBut();
 }
-/*----------------------------------------END Task Definition----------------------------------------*/
-
-/*----------------------------------------Function Definition----------------------------------------*/
 /*
- * Function to initialize button inputs of buddy's board
+ * Task function to draw the newest snapshot of the game. Snapshots published while
+ * it draws are skipped but the newest, frames presented faster than the display
+ * refreshes are dropped by the swap chain without waiting.
  */
-void initBuddyBut(){
-	buddyA = 0;
-	buddyB = 0;
-	buddyC = 0;
-	buddyD = 0;
-	buddyE = 0;
+void renderFrames() {
+	fontsInit();
+	tilesInit(&sceneTiles, sceneColors + renderCellColor, 1);
+	while (TRUE) {
+		xSemaphoreTake(frameChanged, portMAX_DELAY);
+		taskENTER_CRITICAL();
+		const tetrisSnapshot *snapshot = snapshotAcquire(&snapshots);
+		taskEXIT_CRITICAL();
+		if (!snapshot)
+			continue; // Drawn already
+		drawSnapshot(snapshot);
+		latencyDrawn(snapshot->sequence);
+		// Present for the next vertical blank
+		ESPL_DrawLayer();
+		latencySwapped();
+		taskENTER_CRITICAL();
+		snapshotRelease(&snapshots);
+		taskEXIT_CRITICAL();
+	}
 }
+/*----------------------------------------END Task Definition----------------------------------------*/
 
+/*----------------------------------------Function Definition----------------------------------------*/
 /*
  * Function to send data to buddy's board via UART
  */
 void sendData() {
-	int butAState,butBState,butCState,butDState,butEState;
-	butAState = GPIO_ReadInputDataBit(ESPL_Register_Button_A, ESPL_Pin_Button_A);
-	butBState = GPIO_ReadInputDataBit(ESPL_Register_Button_B, ESPL_Pin_Button_B);
-	butCState = GPIO_ReadInputDataBit(ESPL_Register_Button_C, ESPL_Pin_Button_C);
-	butDState = GPIO_ReadInputDataBit(ESPL_Register_Button_D, ESPL_Pin_Button_D);
-	butEState = GPIO_ReadInputDataBit(ESPL_Register_Button_E, ESPL_Pin_Button_E);
-	const uint8_t checkxor1 = butAState ^ butBState;
-	const uint8_t checkxor2 = butCState ^ butDState;
-    UART_SendData(startByte); // Byte 0
-    UART_SendData(butAState); // Byte 1
-    UART_SendData(butBState); // Byte 2
-    UART_SendData(butCState); // Byte 3
-    UART_SendData(butDState); // Byte 4
-    UART_SendData(butEState); // Byte 5
-    UART_SendData(myState); // Byte 6
-    UART_SendData(checkxor1); // Byte 7
-    UART_SendData(checkxor2); // Byte 8
-    UART_SendData(currentX); // Byte 9
-    UART_SendData(currentY); // Byte 10
-    UART_SendData(currentType); // Byte 11
-    UART_SendData(currentColor); // Byte 12
-    UART_SendData(nextType); // Byte 13
-    UART_SendData(nextColor); // Byte 14
-    UART_SendData(stopByte); // Byte 15
-}
-
-/*
- * Function to initialize the system settings of the game
- */
-void systemInit() {
-	currentType = -1; // Value -1 denotes the condition that data is not received yet
-	nextType = -1;
-	buddyCurrentType = -1;
-	buddyNextType = -1;
-	lvl = 0;
-	mode = modeSelect;
-}
-
-/*
- * Function to initialize game setting before starting the game
- */
-void initGameSetting(tetrisBlock *currentTetris, tetrisBlock *nextTetris, int map[arrHeight][arrWidth]){
-	scr = 0;
-	lin = 0;
-	isGameOver = 0;
-	tetrisInit(currentTetris);
-	tetrisInit(nextTetris);
-	if (mode == doublePlayerMove){
-		while(buddyCurrentType == -1 && buddyNextType == -1) // Parameters are not obtained yet
-			vTaskDelay(5);
-		tetrisSynchronization(currentTetris, nextTetris); // Synchronize 2 connected boards
+	uint8_t butState;
+	butState = GPIO_ReadInputDataBit(ESPL_Register_Button_A, ESPL_Pin_Button_A);
+	butState |= GPIO_ReadInputDataBit(ESPL_Register_Button_B, ESPL_Pin_Button_B) << 1;
+	butState |= GPIO_ReadInputDataBit(ESPL_Register_Button_C, ESPL_Pin_Button_C) << 2;
+	butState |= GPIO_ReadInputDataBit(ESPL_Register_Button_D, ESPL_Pin_Button_D) << 3;
+	butState |= GPIO_ReadInputDataBit(ESPL_Register_Button_E, ESPL_Pin_Button_E) << 4;
+	if (linkSeedFrames > 0) { // Seed package of a new game
+		const uint32_t seed = game.seed;
+		linkSeedFrames--;
+		UART_SendData(seedStartByte); // Byte 0
+		UART_SendData(seed & 0xFF); // Byte 1 to 4
+		UART_SendData(seed >> 8 & 0xFF);
+		UART_SendData(seed >> 16 & 0xFF);
+		UART_SendData(seed >> 24);
+		UART_SendData((seed ^ seed >> 8 ^ seed >> 16 ^ seed >> 24) & 0xFF); // Byte 5
+		UART_SendData(stopByte); // Byte 6
 	}
-	else
-		sendTetris(currentTetris, nextTetris); // In single mode directly prepare tetris blocks
-	clearMap(map);
-}
-
-/*
- * Function to check whether a new tetris should appear and start the new round
- */
-int checkNewTetris(tetrisBlock *tetrisPtr, int map[arrHeight][arrWidth]){
-	if (!tetrisMove(tetrisPtr, down, map))
-		return 1; // Need next tetris
-	else return 0;
-}
-
-/*
- * Function to check full lines to be eliminated
- */
-int checkFullLine(int fullLineNumber[5], int map[arrHeight][arrWidth]){
-	int num = 0;
-	for (int row = 19; row >= 0; row--){ // Check from top to bottom
-		int isLineFull = 1;
-		for (int col = 0; col < 10; col++){ // Check from left to right
-			if (map[row][col] == 0){
-				isLineFull = 0;
-				break;
-			}
-		}
-		if (isLineFull){
-			num++; // Record the number of lines to be eliminated
-			fullLineNumber[num] = row; // Record the line to be eliminated
-			for (int col = 0; col < 10; col++){
-				map[row][col] = 0; // Eliminate the target line
-			}
-		}
-	}
-	return num;
+	// The last 8 events, 3 bits each, starting with the newest one
+	taskENTER_CRITICAL(); // The game task logs events meanwhile
+	const uint8_t eventCount = linkEventCount;
+	uint32_t events = 0;
+	for (int n = 0; n < 8; n++)
+		events |= (uint32_t)linkEvents[(uint8_t)(eventCount - 1 - n)] << (3 * n);
+	taskEXIT_CRITICAL();
+	const uint8_t checkxor = butState ^ (uint8_t)myState ^ eventCount ^ events ^ events >> 8 ^ events >> 16;
+    UART_SendData(startByte); // Byte 0
+    UART_SendData(butState); // Byte 1, bit 0 to 4 are the states of button A to E
+    UART_SendData(myState); // Byte 2
+    UART_SendData(eventCount); // Byte 3
+    UART_SendData(events & 0xFF); // Byte 4 to 6
+    UART_SendData(events >> 8 & 0xFF);
+    UART_SendData(events >> 16);
+    UART_SendData(checkxor); // Byte 7
+    UART_SendData(stopByte); // Byte 8
 }
 
 /*
- * Function to move remaining tetris blocks down after eliminating full lines
+ * Function to log an event applied to the game, which buddy's board replays in double mode
  */
-void letLineDisappear(int fullLineNumber[5], int num, int map[arrHeight][arrWidth]){
-	while(num > 0){
-		int emptyLineNumber = fullLineNumber[num]; // Record the empty line to be filled
-		for (int row = emptyLineNumber; row > 0; row--)
-			for (int col = 0; col < 10; col++)
-				map[row][col] = map[row-1][col];
-		num--;
-	}
+void linkEvent(uint8_t event) {
+	taskENTER_CRITICAL(); // The sending task reads the log and its count together
+	linkEvents[linkEventCount] = event;
+	linkEventCount++;
+	taskEXIT_CRITICAL();
 }
 
 /*
- * Function to check whether the game is over
+ * Function to replay the events of buddy's board on the game in double mode,
+ * returns the number of events replayed
  */
-int checkGameOver(tetrisBlock *blockPtr){
-	int isGameOver = 0;
-	for (int i = 0; i < 4; i++){
-		if (blockPtr->position[i].y == 0){
-			isGameOver = 1;
-			break;
-		}
+int linkReplay() {
+	uint8_t event;
+	int eventNum = 0;
+	while (xQueueReceive(buddyEvents, &event, 0) == pdTRUE) {
+		if (event == linkGravityFrame)
+			gameGravity(&game, 1, NULL);
+		else if (event == system_refresh)
+			gameRound(&game, system_refresh); // The tetris rests on the stack and is fixed
+		else
+			gameInput(&game, (button)event);
+		eventNum++;
 	}
-	return isGameOver;
-}
-
-/*
- * Function to clear the fixed tetris on the block map
- */
-void clearMap(int map[arrHeight][arrWidth]){
-	for (int row = 0; row < arrHeight; row++)
-		for (int col = 0; col < arrWidth; col++)
-			map[row][col] = 0;
-}
-
-/*
- * Function to clear the record of coordinates of current tetris in order to get ready for recording the next ones
- */
-void clearTetrisPosition(tetrisBlock* blockPtr, int map[arrHeight][arrWidth]){
-	for (int i = 0; i < 4; i++)
-		map[blockPtr->position[i].y][blockPtr->position[i].x] = 0;
-}
-
-/*
- * Function to draw the fixed tetris block on the map when current tetris block stops moving
- */
-void printTetrisOnMap(tetrisBlock *blockPtr, int map[arrHeight][arrWidth]){
-	// Build fixed tetris
-	for (int i = 0; i < 4; i++)
-		map[blockPtr->position[i].y][blockPtr->position[i].x] = blockPtr->color_num;
-}
-
-/*
- * Function to get the most left horizontal coordinate of current tetris
- */
-int getLeft(tetrisBlock* blockPtr) {
-	int min = 10;
-	for (int i = 0; i < 4; i++){
-		if (blockPtr->position[i].x < min)
-			min = blockPtr->position[i].x ;
+	return eventNum;
+}
+
+/*
+ * Function to check if a local button is used in the game mode, in double mode
+ * each board has its own buttons
+ */
+int localButtonEnabled(button privateButton) {
+	switch (privateButton) {
+	case A:
+		return game.mode == modeSelect || game.mode == singlePlayer || game.mode == doublePlayerRotate || game.mode == doublePlayerSelect;
+	case B:
+	case D:
+		return game.mode == singlePlayer || game.mode == doublePlayerMove || game.mode == doublePlayerSelect || game.mode == modeSelect
+				|| (game.mode == doublePlayerRotate && myState == (int)gamePause);
+	case C:
+		return game.mode == singlePlayer || game.mode == doublePlayerMove || game.mode == doublePlayerSelect || game.mode == modeSelect;
+	case E:
+		return game.mode == singlePlayer || game.mode == doublePlayerRotate;
+	case K: // Hard drop and 20G selection, single mode only
+		return game.mode == singlePlayer || game.mode == modeSelect;
+	default:
+		return 1;
 	}
-	return min; // Record the most left horizontal coordinate
 }
 
 /*
- * Function to get the most right horizontal coordinate of current tetris
+ * Function to check if a move button is still held, in double mode the rotating
+ * board shifts by the buttons of buddy's board
  */
-int getRight(tetrisBlock* blockPtr) {
-	int max = -1;
-	for (int i = 0; i < 4; i++){
-		if (blockPtr->position[i].x > max)
-			max = blockPtr->position[i].x ;
-	}
-	return max; // Record the most right horizontal coordinate
+int buttonHeld(button privateButton) {
+	if (game.mode == doublePlayerRotate)
+		return (privateButton == B ? buddyBState : privateButton == C ? buddyCState : buddyDState) == 0;
+	return debounceHeld(&buttonDebounce, privateButton);
 }
 
 /*
- * Function to check whether there are collisions between current tetris and walls or fixed tetris
+ * Function to apply the auto shift of the held move buttons for the frames passed,
+ * returns the cells the falling tetris moved
  */
-int noCollision(tetrisBlock* blockPtr, int map[arrHeight][arrWidth]){
-	int i;
-	for (i = 0; i <= 3; i++){
-		if (map[blockPtr->position[i].y][blockPtr->position[i].x] != 0)
-			return 0; // Collide with other tetris blocks or walls
+int shiftHeldButtons() {
+	tetrisShift *shifts[2] = {&shiftSide, &shiftDown};
+	int frameNum = shiftFrames, moved = 0;
+	shiftFrames = 0;
+	if (game.mode == doublePlayerMove)
+		return 0; // Buddy's board logs the shifts as events
+	for (int n = 0; n < 2; n++) {
+		button held = (button)shifts[n]->held;
+		int moves = shiftAdvance(shifts[n], shifts[n]->held >= 0 && buttonHeld(held), frameNum);
+		if (!moves)
+			continue;
+		int cells = gameShift(&game, held, moves);
+		if (game.mode == doublePlayerRotate)
+			for (int cell = 0; cell < cells; cell++)
+				linkEvent(held);
+		moved += cells;
 	}
-	return 1;
+	return moved + checkJoystick(frameNum);
 }
 
 /*
- * Function to move next tetris to current one
+ * Function to shift the falling tetris by the joystick in single mode, at a repeat
+ * rate proportional to its deflection. Returns the cells the tetris moved.
  */
-void copyTetris(tetrisBlock *currentTetris, tetrisBlock *nextTetris) {
-	currentTetris->center.x = nextTetris->center.x;
-	currentTetris->center.y = nextTetris->center.y;
-	currentTetris->color_num = nextTetris->color_num;
-	currentTetris->next_type = nextTetris->next_type;
-	currentTetris->type = nextTetris->type;
-	tetrisShape(currentTetris);
+int checkJoystick(int frames) {
+	int moved = 0;
+	int movesX = joystickMoves(&joystickX, frames) * joystickSignX;
+	int movesY = joystickMoves(&joystickY, frames) * joystickSignY;
+	if (game.mode != singlePlayer)
+		return 0; // The moves are not logged as events of the double mode
+	if (movesX)
+		moved += gameShift(&game, movesX > 0 ? B : D, movesX > 0 ? movesX : -movesX);
+	if (movesY > 0) // Soft drop, the joystick never moves the tetris up
+		moved += gameShift(&game, C, movesY);
+	return moved;
 }
 
 /*
- * Function to send current and next tetris parameters to the board
- */
-void sendTetris(tetrisBlock* currentTetris, tetrisBlock* nextTetris) {
-	currentX = currentTetris->center.x;
-	currentY = currentTetris->center.y;
-	currentType = currentTetris->type;
-	currentColor = currentTetris->color_num;
-	nextType = nextTetris->type;
-	nextColor = nextTetris->color_num;
-}
-
-/*
- * Function to generate random tetris
- */
-void tetrisInit(tetrisBlock* blockPtr) {
-	blockPtr->center.x = 4;
-	blockPtr->center.y = 0;
-	blockPtr->type = rand()%28;
-	blockPtr->color_num = rand()%4 + 1; // color[0] used only for background
-	tetrisShape(blockPtr);
-}
-
-/*
- * Function to set types of tetris
+ * Function to initialize the system settings of the game
  */
-void tetrisShape(tetrisBlock* blockPtr){
-	switch (blockPtr->type) {
-	case 0:
-		blockPtr->position[0].x = blockPtr->center.x-1;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y+1;
-		blockPtr->position[3].x = blockPtr->center.x+1;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 1;
-		break;
-	case 1:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y-1;
-		blockPtr->position[1].x = blockPtr->center.x-1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x-1;
-		blockPtr->position[3].y =blockPtr->center.y+1;
-		blockPtr->next_type = 0;
-		break;
-	case 2:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x+1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x-1;
-		blockPtr->position[2].y = blockPtr->center.y+1;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 3;
-		break;
-	case 3:
-		blockPtr->position[0].x = blockPtr->center.x-1;
-		blockPtr->position[0].y = blockPtr->center.y-1;
-		blockPtr->position[1].x = blockPtr->center.x-1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 2;
-		break;
-	case 4:
-		blockPtr->position[0].x = blockPtr->center.x-1;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x+1;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x+1;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 7;
-		break;
-	case 5:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y-1;
-		blockPtr->position[1].x = blockPtr->center.x;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x-1;
-		blockPtr->position[2].y = blockPtr->center.y+1;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 4;
-		break;
-	case 6:
-		blockPtr->position[0].x = blockPtr->center.x-1;
-		blockPtr->position[0].y = blockPtr->center.y-1;
-		blockPtr->position[1].x = blockPtr->center.x-1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x+1;
-		blockPtr->position[3].y = blockPtr->center.y;
-		blockPtr->next_type = 5;
-		break;
-	case 7:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y-1;
-		blockPtr->position[1].x = blockPtr->center.x+1;
-		blockPtr->position[1].y = blockPtr->center.y-1;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 6;
-		break;
-	case 8:
-		blockPtr->position[0].x = blockPtr->center.x+1;
-		blockPtr->position[0].y = blockPtr->center.y-1;
-		blockPtr->position[1].x = blockPtr->center.x-1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x+1;
-		blockPtr->position[3].y = blockPtr->center.y;
-		blockPtr->next_type = 9;
-		break;
-	case 9:
-		blockPtr->position[0].x = blockPtr->center.x-1;
-		blockPtr->position[0].y = blockPtr->center.y-1;
-		blockPtr->position[1].x = blockPtr->center.x;
-		blockPtr->position[1].y = blockPtr->center.y-1;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 10;
-		break;
-	case 10:
-		blockPtr->position[0].x = blockPtr->center.x-1;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x+1;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x-1;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 11;
-		break;
-	case 11:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y-1;
-		blockPtr->position[1].x = blockPtr->center.x;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y+1;
-		blockPtr->position[3].x = blockPtr->center.x+1;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 8;;
-		break;
-	case 12:
-		blockPtr->position[0].x = blockPtr->center.x-1;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x;
-		blockPtr->position[1].y = blockPtr->center.y-1;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 15;
-		break;
-	case 13:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y-1;
-		blockPtr->position[1].x = blockPtr->center.x-1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x+1;
-		blockPtr->position[3].y = blockPtr->center.y;
-		blockPtr->next_type = 12;
-		break;
-	case 14:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y-1;
-		blockPtr->position[1].x = blockPtr->center.x;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y+1;
-		blockPtr->position[3].x = blockPtr->center.x+1;
-		blockPtr->position[3].y = blockPtr->center.y;
-		blockPtr->next_type = 13;
-		break;
-	case 15:
-		blockPtr->position[0].x = blockPtr->center.x-1;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x+1;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 14;
-		break;
-	case 16:
-		blockPtr->position[0].x = blockPtr->center.x-1;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x-1;
-		blockPtr->position[2].y = blockPtr->center.y+1;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 16;
-		break;
-	case 17:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x;
-		blockPtr->position[1].y = blockPtr->center.y+1;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y-1;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y-2;
-		blockPtr->next_type = 18;
-		break;
-	case 18:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x-1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x+1;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x+2;
-		blockPtr->position[3].y = blockPtr->center.y;
-		blockPtr->next_type = 17;
-		break;
-	case 19:
-		blockPtr->position[0].x = blockPtr->center.x-1;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y+1;
-		blockPtr->position[3].x = blockPtr->center.x+1;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 20;
-		break;
-	case 20:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y-1;
-		blockPtr->position[1].x = blockPtr->center.x-1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x-1;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 19;
-		break;
-	case 21:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x+1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x-1;
-		blockPtr->position[2].y = blockPtr->center.y+1;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 22;
-		break;
-	case 22:
-		blockPtr->position[0].x = blockPtr->center.x-1;
-		blockPtr->position[0].y = blockPtr->center.y-1;
-		blockPtr->position[1].x = blockPtr->center.x-1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 21;
-		break;
-	case 23:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x-1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x-1;
-		blockPtr->position[2].y = blockPtr->center.y+1;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 23;
-		break;
-	case 24:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x-1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x-1;
-		blockPtr->position[2].y = blockPtr->center.y+1;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 24;
-		break;
-	case 25:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x-1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x-1;
-		blockPtr->position[2].y = blockPtr->center.y+1;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y+1;
-		blockPtr->next_type = 25;
-		break;
-	case 26:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x;
-		blockPtr->position[1].y = blockPtr->center.y+1;
-		blockPtr->position[2].x = blockPtr->center.x;
-		blockPtr->position[2].y = blockPtr->center.y-1;
-		blockPtr->position[3].x = blockPtr->center.x;
-		blockPtr->position[3].y = blockPtr->center.y-2;
-		blockPtr->next_type = 27;
-		break;
-	case 27:
-		blockPtr->position[0].x = blockPtr->center.x;
-		blockPtr->position[0].y = blockPtr->center.y;
-		blockPtr->position[1].x = blockPtr->center.x-1;
-		blockPtr->position[1].y = blockPtr->center.y;
-		blockPtr->position[2].x = blockPtr->center.x+1;
-		blockPtr->position[2].y = blockPtr->center.y;
-		blockPtr->position[3].x = blockPtr->center.x+2;
-		blockPtr->position[3].y = blockPtr->center.y;
-		blockPtr->next_type = 26;
-		break;
-		// Increase the probability of rare types to reach a balance between all types
+void systemInit() {
+	linkDesync = 0;
+	gameReset(&game);
+}
+
+/*
+ * Function to open the fonts once and to capture the glyphs of the panel text,
+ * drawn by the font onto a key color in the frame buffer being drawn, into the
+ * atlas. Called by the render task before it draws the first scene.
+ */
+void fontsInit(){
+	tetrisSurface surface;
+	fontText = gdispOpenFont("DejaVuSans24*");
+	fontTitle = gdispOpenFont("DejaVuSans32*");
+	fontSmall = gdispOpenFont("UI2");
+	int height = gdispGetFontMetric(fontText, fontHeight);
+	surfaceInitRotated(&surface, (uint16_t *)ESPL_DrawBuffer, displaySizeX, displaySizeY);
+	atlasInit(&sceneAtlas, (uint16_t *)ESPL_FrameBuffer(swapBuffers), sceneAtlasStride, height, Magenta);
+	for (const char *c = atlasCharset; *c; c++){
+		char str[2] = {*c, 0};
+		int advance = gdispGetStringWidth(str, fontText);
+		gdispFillArea(0, 0, advance + 2 * atlasBearing, height, Magenta);
+		gdispDrawString(atlasBearing, 0, str, fontText, sceneColors[renderText]);
+		fillWait(&ESPL_FillEngine);
+		atlasCapture(&sceneAtlas, &surface, *c, atlasBearing, 0, advance);
 	}
 }
 
 /*
- * Function to synchronize the tetris conditions with buddy's board by passing parameters
- */
-void tetrisSynchronization(tetrisBlock *currentTetris, tetrisBlock *nextTetris) {
-	currentTetris->center.x = buddyCurrentX;
-	currentTetris->center.y = buddyCurrentY;
-	currentTetris->type = buddyCurrentType;
-	currentTetris->color_num = buddyCurrentColor;
-	nextTetris->type = buddyNextType;
-	nextTetris->color_num = buddyNextColor;
-	tetrisShape(currentTetris);
-	tetrisShape(nextTetris);
-}
-
-/*
- * Function to control the movement of tetris
+ * Function to initialize game setting before starting the game
  */
-int tetrisMove(tetrisBlock* blockPtr, direction direct, int map[arrHeight][arrWidth]){
-	point pre_center; // Record in case of collision
-	pre_center.x = blockPtr->center.x;
-	pre_center.y = blockPtr->center.y;
-
-	int min = getLeft(blockPtr); // Minimum horizontal coordinate
-	int max = getRight(blockPtr); // Maximum horizontal coordinate
-
-	switch(direct){
-	case down:{
-		blockPtr->center.y++;
-		break;
-	}
-	case left:{
-		if (min > 0) // Not collide with left wall
-			blockPtr->center.x--;
-		break;
-	}
-	case right:{
-		if (max < 9) // Not collide with right wall
-			blockPtr->center.x++;
-		break;
-	}
+void initGameSetting(){
+	// At most one event per frame and direction, so the moves fit into the events of a data package in double mode
+	int repeat = game.mode == singlePlayer || shiftRepeat > 0 ? shiftRepeat : 1;
+	shiftInit(&shiftSide, shiftDelay, repeat);
+	shiftInit(&shiftDown, shiftDownDelayFrames, shiftDownRepeatFrames);
+	if (game.mode == doublePlayerMove){ // Start with the seed of buddy's board to get the same tetris sequence
+		int connectionBreakCount = 0;
+		while(!buddySeedReady){ // Seed is not obtained yet
+			if (connectionBreakCount > 200){
+				linkDesync = 1;
+				break;
+			}
+			connectionBreakCount++;
+			vTaskDelay(5);
+		}
+		buddySeedReady = 0;
+		gameStart(&game, buddySeed);
 	}
-	tetrisShape(blockPtr);
-	if (!noCollision(blockPtr, map)){
-		blockPtr->center.x = pre_center.x;
-		blockPtr->center.y = pre_center.y;
-		tetrisShape(blockPtr); // Shape the original tetris due to collision
-		return 0;
+	else{
+		gameStart(&game, xTaskGetTickCount()); // Seed the tetris sequence with the kernel tick once per game
+		if (game.mode == doublePlayerRotate){
+			linkSeedFrames = seedFrames;
+			linkEventCount = 0;
+		}
 	}
-	else
-		return 1; // Tetris can move
 }
 
 /*
- * Function to control the rotation of tetris
+ * Function to publish a snapshot of the game for the render task, page selects
+ * the page of the pause scene
  */
-void tetrisRotate(tetrisBlock* blockPtr, int map[arrHeight][arrWidth]){
-	int pre_type = blockPtr->type;
-	blockPtr->type = blockPtr->next_type;
-	tetrisShape(blockPtr);
-	int min = getLeft(blockPtr);
-	int max = getRight(blockPtr);
-	if (min < 0 || max > 9 || (!noCollision(blockPtr, map))){
-		blockPtr->type = pre_type;
-		tetrisShape(blockPtr);
-	}
+void publishFrame(currentState frameState, int page) {
+	taskENTER_CRITICAL();
+	tetrisSnapshot *snapshot = snapshotBeginWrite(&snapshots);
+	taskEXIT_CRITICAL();
+	snapshotCapture(snapshot, &game, frameState, page); // The render task never holds this slot
+	taskENTER_CRITICAL();
+	snapshotEndWrite(&snapshots);
+	taskEXIT_CRITICAL();
+	xSemaphoreGive(frameChanged);
 }
 
 /*
- * Function to get the next game state based on current state
+ * Function to draw the scene of a snapshot into the back layer
  */
-currentState getState(currentState state, button privateButton) {
-	switch(state){
-	case gameMenu:{
-		if (privateButton == A){ // Start single mode
-			mode = singlePlayer;
-			globalSpeed = singleModeSpeed;
-			return initGame;
-		}
-		if (privateButton == C && connected){ // Start double mode only when 2 boards are connected
-			mode = doublePlayerSelect;
-			globalSpeed = doubleModeSpeed;
-			return select;
-		}
-		else { // Set game level from 0 to 3
-			if (privateButton == B && lvl < 3)
-				lvl++;
-			else if (privateButton == D && lvl > 0)
-				lvl--;
-			return gameMenu;
-		}
-		break;
-	}
-	case select:
-	{
-		if (!connected)
-		{
-			systemInit();
-			return gameMenu;
-		}
-		if (privateButton == A) {
-			if (buddyA)
-				mode = doublePlayerRotate;
-			else
-				mode = doublePlayerMove;
-			return initGame;
-		}
-
-		if (privateButton == C) {
-			if (buddyC)
-				mode = doublePlayerMove;
-			else
-				mode = doublePlayerRotate;
-			return initGame;
-		}
-		else { // Set game level from 0 to 3
-			if (privateButton == B && lvl < 3)
-				lvl++;
-			else if (privateButton == D && lvl > 0)
-				lvl--;
-			return select;
-		}
+void drawSnapshot(const tetrisSnapshot *snapshot) {
+	switch (snapshot->state) {
+	case gameMenu:
+		drawGameMenu(snapshot);
 		break;
-	}
-	case initGame:{
-		if (!connected && (mode == doublePlayerMove || mode == doublePlayerRotate))
-		{
-			systemInit();
-			return gameMenu;
-		}
-		return inGame;
+	case selectMenu:
+		drawSelectMode(snapshot);
 		break;
-	}
-	case inGame:{
-		if (!connected && (mode == doublePlayerMove || mode == doublePlayerRotate)) {
-			systemInit();
-			return gameMenu;
-		}
-		if (privateButton == system_refresh) // No operation
-			return nextRound;
-		if (privateButton == A || privateButton == B ||privateButton == C || privateButton == D) // Move and rotate tetris
-			return inGame;
-		if (privateButton == E) // Pause the game
-			return gamePause;
-		break;
-	}
-	case gamePause:{
-		if (!connected && (mode == doublePlayerMove || mode == doublePlayerRotate)) {
-			systemInit();
-			return gameMenu;
-		}
-		if (privateButton == D) {
-			if (mode == doublePlayerMove)
-				return nextRound;
-			return inGame; // Resume the game if D is pressed
-		}
-		else if (privateButton == B)
-			return gameOver; // End the game if B is pressed
-		else if (privateButton == A)
-			return initGame; // Restart the game if A is pressed
-		return gamePause; // The system remain in the pause scene waiting for the input if no operation is executed
+	case initGame:
+	case inGame:
+	case nextRound:
+		drawGameEnvironment(snapshot);
 		break;
-	}
-	case nextRound:{
-		if (isGameOver)
-			return gameOver;
-		else {
-			if (!connected && (mode == doublePlayerMove || mode == doublePlayerRotate)) {
-				systemInit();
-				return gameMenu;
-			}
-			if (mode == doublePlayerMove) {
-				if (privateButton == E) // Pause the game
-					return gamePause;
-				return nextRound;
-			}
-		    else
-			    return inGame;
-		}
-		break;
-	}
-	case gameOver:{
-		if (privateButton != system_refresh) { // Press any button to exit to menu
-			systemInit();
-			return gameMenu;
-		}
+	case gamePause:
+		if (snapshot->page == snapshotLatency)
+			drawLatency();
 		else
-			return gameOver;
+			drawPause(snapshot);
+		break;
+	case gameOver:
+		drawGameOver(snapshot);
 		break;
 	}
-	}
+	if (snapshot->state != initGame && snapshot->state != inGame && snapshot->state != nextRound)
+		sceneShadows[ESPL_SwapChain.drawing].valid = 0; // The next game scene in this frame buffer is drawn as a whole
 }
 
 /*
  * Function to draw the main menu in menu mode
  */
-void drawGameMenu() {
+void drawGameMenu(const tetrisSnapshot *snapshot) {
 	char str[100]; // buffer for messages to draw to display
 
-	// Load font for ugfx
-	font_t font1;
-	font1 = gdispOpenFont("DejaVuSans24*");
-	font_t font2;
-	font2 = gdispOpenFont("DejaVuSans32*");
-
 	gdispClear(White);// Clear background
 
 	// Menu interface
 	const char *title = "TETRIS";
-	gdispDrawString(103, 30, title, font2, Green);
+	gdispDrawString(103, 30, title, fontTitle, Green);
 
 	const char *sgl = "Single Mode(A)";
-	gdispDrawString(120, 80, sgl, font1, Black);
+	gdispDrawString(120, 80, sgl, fontText, Black);
 	gdispDrawBox(100, 70, 120, 30, Green);
 
 	const char *dbl = "Double Mode(C)";
-	gdispDrawString(118, 130, dbl, font1, Black);
+	gdispDrawString(118, 130, dbl, fontText, Black);
 	gdispDrawBox(100, 120, 120, 30, Green);
 
-	sprintf(str, "Level: %2d", lvl);
-	gdispDrawString(140, 180, str, font1, Black);
+	sprintf(str, "Level: %2d", snapshot->level);
+	gdispDrawString(140, 180, str, fontText, Black);
 	gdispDrawBox(110, 170, 100, 30, Green);
+	if (snapshot->gravity20G)
+		gdispDrawString(220, 180, "20G(K)", fontText, Red);
 
 	const char *author = "Produced by: Chen Yuzong & Zhai Yueliang";
-	gdispDrawString(45, 220, author, font1, Blue);
-
-	// Wait for display to stop writing
-	xSemaphoreTake(ESPL_DisplayReady, portMAX_DELAY);
-	// swap buffers
-	ESPL_DrawLayer();
+	gdispDrawString(45, 220, author, fontText, Blue);
 }
 
 /*
  * Function to draw the main menu in select mode
  */
-void drawSelectMode(int selected) {
+void drawSelectMode(const tetrisSnapshot *snapshot) {
 	char str[100]; // buffer for messages to draw to display
 
-	// Load font for ugfx
-	font_t font1;
-	font1 = gdispOpenFont("DejaVuSans24*");
-	font_t font2;
-	font2 = gdispOpenFont("DejaVuSans32*");
-
 	gdispClear(White);
-	xSemaphoreTake(ESPL_DisplayReady, portMAX_DELAY);
 
 	// Menu interface
 	const char *title = "TETRIS";
-	gdispDrawString(103, 30, title, font2, Green);
+	gdispDrawString(103, 30, title, fontTitle, Green);
 
 	const char *sgl = "Control Move(A)";
-	gdispDrawString(111, 80, sgl, font1, Black);
+	gdispDrawString(111, 80, sgl, fontText, Black);
 	gdispDrawBox(100, 70, 120, 30, Green);
 
 	const char *dbl = "Control Rotate(C)";
-	gdispDrawString(114, 130, dbl, font1, Black);
+	gdispDrawString(114, 130, dbl, fontText, Black);
 	gdispDrawBox(100, 120, 120, 30, Green);
 
-	sprintf(str, "Level: %2d", lvl);
-	gdispDrawString(140, 180, str, font1, Black);
+	sprintf(str, "Level: %2d", snapshot->level);
+	gdispDrawString(140, 180, str, fontText, Black);
 	gdispDrawBox(110, 170, 100, 30, Green);
 
 	const char *author = "Produced by: Chen Yuzong & Zhai Yueliang";
-	gdispDrawString(45, 220, author, font1, Blue);
+	gdispDrawString(45, 220, author, fontText, Blue);
+}
+
+/*
+ * Functions to draw the game scene by gdisp, the text of the panels from the
+ * atlas and the cells as tiles. The tiles queued are started before anything
+ * else is drawn, so the DMA2D draws in the order of the renderer.
+ */
+static void sceneFill(void *context, int x, int y, int cx, int cy, int colorNum){
+	blitFlush(&sceneBlits);
+	gdispFillArea(x, y, cx, cy, sceneColors[colorNum]);
+}
+
+static void sceneBox(void *context, int x, int y, int cx, int cy, int colorNum){
+	blitFlush(&sceneBlits);
+	gdispDrawBox(x, y, cx, cy, sceneColors[colorNum]);
+}
 
-	// Wait for display to stop writing
-	xSemaphoreTake(ESPL_DisplayReady, portMAX_DELAY);
-	// swap buffers
-	ESPL_DrawLayer();
+static void sceneText(void *context, int x, int y, const char *text, int colorNum){
+	tetrisSurface surface;
+	surfaceInitRotated(&surface, (uint16_t *)ESPL_DrawBuffer, displaySizeX, displaySizeY);
+	blitFlush(&sceneBlits);
+	fillWait(&ESPL_FillEngine); // The CPU draws over the fills and blits
+	if (colorNum == renderText && atlasDrawText(&sceneAtlas, &surface, x, y, text))
+		return;
+	gdispDrawString(x, y, text, fontText, sceneColors[colorNum]); // Text of the mode line
+}
+
+static void sceneCopy(void *context, int x, int y, int cx, int cy){
+	tetrisSurface target, source;
+	surfaceInitRotated(&target, (uint16_t *)ESPL_DrawBuffer, displaySizeX, displaySizeY);
+	surfaceInitRotated(&source, (uint16_t *)sceneHudBuffer, displaySizeX, displaySizeY);
+	blitFlush(&sceneBlits);
+	fillWait(&ESPL_FillEngine);
+	surfaceCopy(&target, &source, x, y, cx, cy);
+}
+
+static void sceneTile(void *context, int x, int y, int look){
+	tetrisSurface surface;
+	surfaceInitRotated(&surface, (uint16_t *)ESPL_DrawBuffer, displaySizeX, displaySizeY);
+	blitTile(&sceneBlits, &surface, x, y, tilesLook(&sceneTiles, look));
 }
 
 /*
- * Function to draw the game environment when playing
+ * Function to draw the static layer of the game scene of a mode into its own
+ * buffer, by pointing gdisp at it while it is drawn
  */
-void drawGameEnvironment(tetrisBlock* nextTetris, int map[arrHeight][arrWidth]){
-	// Load font for ugfx
-	font_t font1;
-	font1 = gdispOpenFont("DejaVuSans24*");
-	font_t font2;
-	font2 = gdispOpenFont("DejaVuSans32*");
-
-	gdispClear(Green); // Background
-
-	gdispFillArea(230, 10, 80, 35, White);
-	const char *score = "SCORE";
-	gdispDrawString(245, 15, score, font1, Black);
-
-	gdispFillArea(230, 55, 80, 35, White);
-	const char *level = "LEVEL";
-	gdispDrawString(245, 60, level, font1, Black);
-
-	gdispFillArea(230, 100, 80, 35, White);
-	const char *line = "LINE";
-	gdispDrawString(245, 105, line, font1, Black);
-
-	gdispFillArea(230, 145, 80, 85, White);
-	const char *next = "NEXT";
-	gdispDrawString(245, 150, next, font1, Black);
-
-	gdispFillArea(10, 10, 90, 220, White); // Instructions for game operations
-	const char *operation = "Operations:";
-	const char *operation1 = "A  Rotate";
-	const char *operation2 = "B  Move right";
-	const char *operation3 = "C  Move down";
-	const char *operation4 = "D  Move left";
-	const char *operation5 = "E  Pause";
-	const char *operation6 = "F  Menu";
-	gdispDrawString(15, 20, operation, font1, Black);
-	gdispDrawString(15, 40, operation1, font1, Black);
-	gdispDrawString(15, 60, operation2, font1, Black);
-	gdispDrawString(15, 80, operation3, font1, Black);
-	gdispDrawString(15, 100, operation4, font1, Black);
-	gdispDrawString(15, 120, operation5, font1, Black);
-	gdispDrawString(15, 140, operation6, font1, Black);
-
-    // Print instruction for double mode
-	const char *myGameMode1 = "You Move";
-	const char *myGameMode2 = "You Rotate";
-	if (mode == doublePlayerMove)
-		gdispDrawString(25, 190, myGameMode1, font1, Red);
-	else if (mode == doublePlayerRotate)
-		gdispDrawString(25, 190, myGameMode2, font1, Red);
-
-	char str1[50], str2[50], str3[50];
-	sprintf(str1, "%5d",scr);
-	gdispDrawString(245, 30, str1, font1, Black);
-	sprintf(str2, "%5d",lvl);
-	gdispDrawString(245, 75, str2, font1, Black);
-	sprintf(str3, "%5d",lin);
-	gdispDrawString(245, 120, str3, font1, Black);
-
-	// Draw tetris blocks based on array map
-	for (int row = 0; row < 20; row++){
-		for (int col = 0; col < 10; col++){
-			if (map[row][col] != 0)
-				gdispFillArea(110+11*col, 10+11*row, 10, 10, color[map[row][col]]);
-			else
-				gdispFillArea(110+11*col, 10+11*row, 10, 10, color[0]);
-		}
-	}
+void drawHud(currentMode mode){
+	renderTarget target = {NULL, sceneFill, sceneBox, sceneText, NULL, sceneTile, 0};
+	uint32_t drawBuffer = ESPL_DrawBuffer;
+	ESPL_DrawBuffer = sceneHudBuffer;
+	renderHud(&target, mode);
+	blitFlush(&sceneBlits);
+	ESPL_DrawBuffer = drawBuffer;
+	sceneHudMode = mode;
+}
 
-	// Draw next tetris prediction
-	for (int i = 0; i < 4; i++)
-		gdispFillArea(225+10*nextTetris->position[i].x, 190+10*nextTetris->position[i].y, 11, 11, color[nextTetris->color_num]);
+/*
+ * Function to draw the game scene, only the cells and panels which changed since
+ * the last game scene drawn into the same frame buffer
+ */
+void drawGameEnvironment(const tetrisSnapshot *snapshot){
+	renderTarget target = {NULL, sceneFill, sceneBox, sceneText, sceneCopy, sceneTile, 0};
 
-	// Swap buffers
-	ESPL_DrawLayer();
+	if ((int)snapshot->mode != sceneHudMode) // Once for the first game of a mode
+		drawHud(snapshot->mode);
+	renderGame(&target, &sceneShadows[ESPL_SwapChain.drawing], snapshot);
+	blitFlush(&sceneBlits); // Waited for as the frame is presented
+	sceneFrames++;
+	sceneCalls += target.calls;
 }
 
 /*
  * Function to draw the pause scene
  */
-void drawPause(){
+void drawPause(const tetrisSnapshot *snapshot){
 	char str1[100], str2[100], str3[100], str4[100];
-    font_t font2 = gdispOpenFont("DejaVuSans32*");
 
 	gdispClear(White);
-	xSemaphoreTake(ESPL_DisplayReady, portMAX_DELAY);
 
 	sprintf(str1, "PAUSE");
 	sprintf(str2, "Press D to continue");
 	sprintf(str3, "Press B to exit");
 	sprintf(str4, "Press A to reset");
-	gdispDrawString(110, 20, str1, font2, Blue);
-	gdispDrawString(5, 75, str2, font2, Blue);
-	gdispDrawString(40, 115, str3, font2, Blue);
-	gdispDrawString(40, 155, str4, font2, Blue);
+	gdispDrawString(110, 20, str1, fontTitle, Blue);
+	gdispDrawString(5, 75, str2, fontTitle, Blue);
+	gdispDrawString(40, 115, str3, fontTitle, Blue);
+	gdispDrawString(40, 155, str4, fontTitle, Blue);
+	if (snapshot->mode == singlePlayer)
+		gdispDrawString(25, 195, "Press K for latency", fontTitle, Blue);
+}
+
+/*
+ * Function to draw the latency histograms of the local buttons on the pause scene, in microseconds
+ */
+void drawLatency(){
+	char str[60];
+
+	gdispClear(White);
 
-	ESPL_DrawLayer();
+	gdispDrawString(10, 10, "Latency (us)   count    min    avg    p99    max", fontSmall, Blue);
+	for (int n = 0; n < latencyStages; n++){
+		latencyFormat(&latencyStats[n], latencyStageNames[n], latencyCountsPerUs, str, sizeof(str));
+		gdispDrawString(10, 30 + 16 * n, str, fontSmall, Black);
+	}
+	sprintf(str, "coalesced %lu  dropped %lu", (unsigned long)latencyCoalesced, (unsigned long)inputDrops);
+	gdispDrawString(10, 30 + 16 * latencyStages, str, fontSmall, Black);
+	sprintf(str, "frames rendered %lu  skipped %lu", (unsigned long)snapshots.rendered, (unsigned long)snapshots.skipped);
+	gdispDrawString(10, 46 + 16 * latencyStages, str, fontSmall, Black);
+	sprintf(str, "display shown %lu  dropped %lu  torn %lu", (unsigned long)ESPL_SwapChain.shown,
+			(unsigned long)ESPL_SwapChain.dropped, (unsigned long)ESPL_SwapChain.torn);
+	gdispDrawString(10, 62 + 16 * latencyStages, str, fontSmall, Black);
+	sprintf(str, "game scenes %lu  draw calls per scene %lu", (unsigned long)sceneFrames,
+			(unsigned long)(sceneFrames ? sceneCalls / sceneFrames : 0));
+	gdispDrawString(10, 78 + 16 * latencyStages, str, fontSmall, Black);
+	uint32_t frames = snapshots.rendered ? snapshots.rendered : 1;
+	sprintf(str, "per frame fills %lu  tiles %lu  cpu cycles %lu", (unsigned long)(ESPL_FillEngine.fills / frames),
+			(unsigned long)(sceneBlits.blitCount / frames), (unsigned long)((ESPL_FillEngine.busy + sceneBlits.busy) / frames));
+	gdispDrawString(10, 94 + 16 * latencyStages, str, fontSmall, Black);
+	gdispDrawString(10, 200, "Press D to continue", fontSmall, Blue);
 }
 
 /*
  * Function to draw the game-over scene
  */
-void drawGameOver(){
+void drawGameOver(const tetrisSnapshot *snapshot){
 	char str1[100], str2[100];
-	font_t font2 = gdispOpenFont("DejaVuSans32*");
 
 	gdispClear(White);
-	xSemaphoreTake(ESPL_DisplayReady, portMAX_DELAY);
 
 	sprintf(str1, "Game Over !!!");
-	sprintf(str2, "Score: %d", scr); // Display the final score
-	gdispDrawString(45, 70, str1, font2, Red);
-	gdispDrawString(45, 125, str2, font2, Red);
-
-	//Set to fixed frame rate
-	ESPL_DrawLayer();
+	sprintf(str2, "Score: %d", snapshot->score); // Display the final score
+	gdispDrawString(45, 70, str1, fontTitle, Red);
+	gdispDrawString(45, 125, str2, fontTitle, Red);
 }
 /*----------------------------------------END Function Definition----------------------------------------*/
 
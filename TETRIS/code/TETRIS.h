@@ -13,6 +13,6 @@ struct coord {
 
 void uartReceive();
 void sendLine(struct coord coord_1, struct coord coord_2);
-void checkJoystick();
+int checkJoystick(int frames);
 
 #endif
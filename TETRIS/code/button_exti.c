@@ -0,0 +1,113 @@
+/**
+ * Button interrupts of the TETRIS game.
+ *
+ * Button E is PA0 on EXTI line 0, button D, K, B, C and A are PE2 to PE6 on
+ * line 2 to 6. Line 5 and 6 share the EXTI9_5 interrupt.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "includes.h"
+#include "input_queue.h"
+#include "button_exti.h"
+
+#define buttonInterruptPriority configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY // Highest priority allowed to call the FreeRTOS API
+
+struct buttonPin {
+	GPIO_TypeDef *port;
+	uint16_t pin;
+	uint8_t portSource, pinSource;
+	uint32_t line;
+	uint8_t irq;
+};
+
+// In the order of the buttons A to E and K
+static const struct buttonPin buttonPins[debounceButtons] = {
+	{GPIOE, GPIO_Pin_6, EXTI_PortSourceGPIOE, EXTI_PinSource6, EXTI_Line6, EXTI9_5_IRQn},
+	{GPIOE, GPIO_Pin_4, EXTI_PortSourceGPIOE, EXTI_PinSource4, EXTI_Line4, EXTI4_IRQn},
+	{GPIOE, GPIO_Pin_5, EXTI_PortSourceGPIOE, EXTI_PinSource5, EXTI_Line5, EXTI9_5_IRQn},
+	{GPIOE, GPIO_Pin_2, EXTI_PortSourceGPIOE, EXTI_PinSource2, EXTI_Line2, EXTI2_IRQn},
+	{GPIOA, GPIO_Pin_0, EXTI_PortSourceGPIOA, EXTI_PinSource0, EXTI_Line0, EXTI0_IRQn},
+	{GPIOE, GPIO_Pin_3, EXTI_PortSourceGPIOE, EXTI_PinSource3, EXTI_Line3, EXTI3_IRQn}
+};
+
+tetrisDebounce buttonDebounce;
+
+/*
+ * Function to connect the button pins, already set up as inputs with pull up
+ * by ESPL_SystemInit, to interrupts on both edges
+ */
+void buttonInit() {
+	EXTI_InitTypeDef EXTI_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	debounceInit(&buttonDebounce, buttonDebounceTime);
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_SYSCFG, ENABLE);
+
+	for (int n = 0; n < debounceButtons; n++) {
+		const struct buttonPin *key = &buttonPins[n];
+		SYSCFG_EXTILineConfig(key->portSource, key->pinSource);
+		EXTI_InitStructure.EXTI_Line = key->line;
+		EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+		EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising_Falling;
+		EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+		EXTI_Init(&EXTI_InitStructure);
+
+		NVIC_InitStructure.NVIC_IRQChannel = key->irq;
+		NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = buttonInterruptPriority;
+		NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+		NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+		NVIC_Init(&NVIC_InitStructure);
+	}
+}
+
+/*
+ * Function to keep the debouncing right across wraps of TIM5, called by the gravity timer every frame
+ */
+void buttonTick() {
+	debounceTick(&buttonDebounce, TIM5->CNT);
+}
+
+/*
+ * Function to debounce the pending edge of a button and post a new press
+ */
+static void buttonEdge(int index, BaseType_t *higherPriorityTaskWoken) {
+	const struct buttonPin *key = &buttonPins[index];
+	if (EXTI_GetITStatus(key->line) == RESET)
+		return;
+	EXTI_ClearITPendingBit(key->line);
+	int level = GPIO_ReadInputDataBit(key->port, key->pin);
+	if (debounceEdge(&buttonDebounce, index, level, TIM5->CNT))
+		inputPostFromISR((button)index, inputLocal, higherPriorityTaskWoken);
+}
+
+void EXTI0_IRQHandler(void) {
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+	buttonEdge(E, &higherPriorityTaskWoken);
+	portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+void EXTI2_IRQHandler(void) {
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+	buttonEdge(D, &higherPriorityTaskWoken);
+	portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+void EXTI3_IRQHandler(void) {
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+	buttonEdge(K, &higherPriorityTaskWoken);
+	portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+void EXTI4_IRQHandler(void) {
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+	buttonEdge(B, &higherPriorityTaskWoken);
+	portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+void EXTI9_5_IRQHandler(void) {
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+	buttonEdge(C, &higherPriorityTaskWoken);
+	buttonEdge(A, &higherPriorityTaskWoken);
+	portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
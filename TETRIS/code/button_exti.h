@@ -0,0 +1,23 @@
+/**
+ * Button interrupts of the TETRIS game.
+ *
+ * Every edge of the button pins raises an EXTI interrupt, which debounces it by
+ * its TIM5 timestamp in tetris_debounce and posts a press straight into the
+ * input event queue.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef button_exti_INCLUDED
+#define button_exti_INCLUDED
+
+#include "tetris_debounce.h"
+
+#define buttonDebounceTime (configCPU_CLOCK_HZ / 2 / 1000 * 5) // 5 ms in TIM5 counts
+
+extern tetrisDebounce buttonDebounce;
+
+void buttonInit();
+void buttonTick();
+
+#endif
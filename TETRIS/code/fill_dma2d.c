@@ -0,0 +1,132 @@
+/**
+ * Rectangle fills and tile blits of the TETRIS game by the Chrom-ART
+ * accelerator.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "includes.h"
+#include "fill_dma2d.h"
+
+#define fillInterruptPriority configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY // Highest priority allowed to call the FreeRTOS API
+
+static volatile int fillBusy = 0; // A fill or a batch runs on the DMA2D
+static SemaphoreHandle_t fillDone; // Given by the transfer complete interrupt of the last transfer
+static tetrisBlit fillBatch[blitQueueLength]; // Batch of blits running
+static volatile int fillBatchNext = 0, fillBatchCount = 0;
+
+static uint32_t fillCycles(void) {
+	return DWT->CYCCNT;
+}
+
+static void fillDma2dWait(void *context) {
+	(void) context;
+	while (fillBusy) // A token left by a transfer nobody waited for is taken and the flag checked again
+		xSemaphoreTake(fillDone, portMAX_DELAY);
+}
+
+/*
+ * Function to start a fill once the DMA2D is done, the registers written
+ * directly for every transfer
+ */
+static void fillDma2dStart(void *context, const tetrisFill *fill) {
+	fillDma2dWait(context);
+	if (fill->length * fill->lines < fillDma2dMinimum) {
+		fillRun(fill);
+		return;
+	}
+	DMA2D->CR = (DMA2D->CR & ~DMA2D_CR_MODE) | DMA2D_R2M;
+	DMA2D->OMAR = (uint32_t)fill->output;
+	DMA2D->OOR = (uint32_t)fill->offset;
+	DMA2D->NLR = ((uint32_t)fill->length << 16) | (uint32_t)fill->lines;
+	DMA2D->OCOLR = fill->color;
+	fillBusy = 1;
+	DMA2D_StartTransfer();
+}
+
+/*
+ * Function to start the next blit of the batch
+ */
+static void fillBatchStart(void) {
+	const tetrisBlit *blit = &fillBatch[fillBatchNext++];
+	DMA2D->FGMAR = (uint32_t)blit->input;
+	DMA2D->FGOR = (uint32_t)blit->inputOffset;
+	DMA2D->OMAR = (uint32_t)blit->output;
+	DMA2D->OOR = (uint32_t)blit->outputOffset;
+	DMA2D->NLR = ((uint32_t)blit->length << 16) | (uint32_t)blit->lines;
+	DMA2D_StartTransfer();
+}
+
+/*
+ * Function to start a batch of blits once the DMA2D is done, the interrupt
+ * starts the blits after the first one
+ */
+static void blitDma2dStart(void *context, const tetrisBlit *blits, int count) {
+	fillDma2dWait(context);
+	memcpy(fillBatch, blits, sizeof(tetrisBlit) * count);
+	fillBatchNext = 0;
+	fillBatchCount = count;
+	DMA2D->CR = (DMA2D->CR & ~DMA2D_CR_MODE) | DMA2D_M2M;
+	fillBusy = 1;
+	fillBatchStart();
+}
+
+void DMA2D_IRQHandler(void) {
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+	if (DMA2D_GetITStatus(DMA2D_IT_TC) != RESET) {
+		DMA2D_ClearITPendingBit(DMA2D_IT_TC);
+		if (fillBatchNext < fillBatchCount)
+			fillBatchStart();
+		else {
+			fillBatchCount = 0;
+			fillBusy = 0;
+			xSemaphoreGiveFromISR(fillDone, &higherPriorityTaskWoken);
+		}
+	}
+	portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+/*
+ * Function to move the fills of an engine and the blits of a queue to the
+ * DMA2D, or to keep them on the CPU, all clocked by the cycle counter. Called
+ * before the scheduler starts, the transfers waiting on the interrupt are
+ * started by the render task.
+ */
+void fillDma2dInit(tetrisFillEngine *engine, tetrisBlitQueue *queue) {
+	fillWait(engine);
+	fillSoftwareInit(engine);
+	blitSoftwareInit(queue);
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	engine->clock = fillCycles;
+	queue->clock = fillCycles;
+#if fillUseDma2d
+	DMA2D_InitTypeDef DMA2D_InitStructure;
+	DMA2D_FG_InitTypeDef DMA2D_FG_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	fillDone = xSemaphoreCreateBinary();
+	RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_DMA2D, ENABLE);
+	DMA2D_DeInit();
+	DMA2D_StructInit(&DMA2D_InitStructure);
+	DMA2D_InitStructure.DMA2D_Mode = DMA2D_R2M;
+	DMA2D_InitStructure.DMA2D_CMode = DMA2D_RGB565;
+	DMA2D_Init(&DMA2D_InitStructure);
+	DMA2D_FG_StructInit(&DMA2D_FG_InitStructure);
+	DMA2D_FG_InitStructure.DMA2D_FGCM = CM_RGB565; // Tiles are in the format of the frame buffers
+	DMA2D_FGConfig(&DMA2D_FG_InitStructure);
+	DMA2D_ITConfig(DMA2D_IT_TC, ENABLE);
+
+	NVIC_InitStructure.NVIC_IRQChannel = DMA2D_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = fillInterruptPriority;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
+	engine->start = fillDma2dStart;
+	engine->wait = fillDma2dWait;
+	queue->start = blitDma2dStart;
+	queue->wait = fillDma2dWait;
+#endif
+}
@@ -0,0 +1,33 @@
+/**
+ * Rectangle fills and tile blits of the TETRIS game by the Chrom-ART
+ * accelerator.
+ *
+ * The fills of the gdisp driver are started on the DMA2D in its register to
+ * memory mode, the batches of tile blits in its memory to memory mode, and the
+ * render task goes on while the DMA2D writes the frame buffer. The DMA2D runs
+ * one transfer at a time: the transfer complete interrupt starts the next blit
+ * of a batch, and a fill or a batch started while another one runs waits for
+ * it, in the order they were started. fillWait and blitWait wait for all of
+ * them, blocked on the interrupt so the other tasks run meanwhile. Fills of
+ * fewer than fillDma2dMinimum pixels, the pixels of the glyphs, cost less on
+ * the CPU than starting the DMA2D and run there once the DMA2D is done.
+ *
+ * The DWT cycle counter clocks both engines, so the latency page shows the CPU
+ * cycles of the fills and blits per frame, for either engine selected by
+ * fillUseDma2d.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef fill_dma2d_INCLUDED
+#define fill_dma2d_INCLUDED
+
+#include "tetris_blit.h"
+#include "tetris_fill.h"
+
+#define fillUseDma2d 1 // 0 runs the fills and blits on the CPU, to compare the cycles
+#define fillDma2dMinimum 64 // Pixels of the smallest fill started on the DMA2D
+
+void fillDma2dInit(tetrisFillEngine *engine, tetrisBlitQueue *queue);
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * Gravity timer of the TETRIS game.
+ *
+ * The jitter of the frames is measured the way of the high speed timer test in
+ * Libraries/usr/timertest.c: a second timer runs free without interrupts and is
+ * captured as the interrupt is entered, and the largest difference of 2 captures
+ * beyond the expected frame period is the jitter. TIM5 is used for the capture
+ * as its 32 bit counter holds a whole frame at the full timer clock.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "includes.h"
+#include "gravity_timer.h"
+#include "button_exti.h"
+
+#define gravityTimerClock (configCPU_CLOCK_HZ / 2) // APB1 timer clock
+#define gravityTimerPrescaler (gravityTimerClock / 60000) // 60 kHz counter clock
+#define gravityExpectedDifference (gravityTimerClock / gravityFrameRate) // TIM5 counts per frame without jitter
+#define gravityInterruptPriority configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY // Highest priority allowed to call the FreeRTOS API
+#define gravitySettleTime 5 // Frames to pass before looking at the jitter
+
+SemaphoreHandle_t frameReady;
+volatile uint32_t gravityFrames = 0;
+volatile uint32_t gravityMaxJitter = 0;
+
+/*
+ * Function to start the frame interrupt of TIM4 and the free running TIM5
+ */
+void gravityTimerInit() {
+	TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	frameReady = xSemaphoreCreateBinary();
+
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM4, ENABLE);
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM5, ENABLE);
+	TIM_DeInit(TIM4);
+	TIM_DeInit(TIM5);
+	TIM_TimeBaseStructInit(&TIM_TimeBaseStructure);
+
+	// TIM4 overflows once per frame
+	TIM_TimeBaseStructure.TIM_Prescaler = gravityTimerPrescaler - 1;
+	TIM_TimeBaseStructure.TIM_Period = gravityTimerClock / gravityTimerPrescaler / gravityFrameRate - 1;
+	TIM_TimeBaseStructure.TIM_ClockDivision = 0;
+	TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+	TIM_TimeBaseInit(TIM4, &TIM_TimeBaseStructure);
+	TIM_ARRPreloadConfig(TIM4, ENABLE);
+
+	// TIM5 counts the timer clock for the jitter measurement
+	TIM_TimeBaseStructure.TIM_Prescaler = 0;
+	TIM_TimeBaseStructure.TIM_Period = 0xFFFFFFFF;
+	TIM_TimeBaseInit(TIM5, &TIM_TimeBaseStructure);
+
+	NVIC_InitStructure.NVIC_IRQChannel = TIM4_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = gravityInterruptPriority;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+	TIM_ITConfig(TIM4, TIM_IT_Update, ENABLE);
+
+	TIM_Cmd(TIM5, ENABLE);
+	TIM_Cmd(TIM4, ENABLE);
+}
+
+void TIM4_IRQHandler(void) {
+	static uint32_t lastCount = 0, settleCount = 0;
+	uint32_t thisCount = TIM5->CNT; // Capture the free running timer as the interrupt is entered
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+	if (settleCount >= gravitySettleTime) {
+		uint32_t difference = thisCount - lastCount;
+		uint32_t jitter = difference > gravityExpectedDifference ? difference - gravityExpectedDifference
+				: gravityExpectedDifference - difference;
+		if (jitter > gravityMaxJitter)
+			gravityMaxJitter = jitter;
+	}
+	else
+		settleCount++;
+	lastCount = thisCount;
+
+	gravityFrames++;
+	buttonTick();
+	xSemaphoreGiveFromISR(frameReady, &higherPriorityTaskWoken);
+	TIM_ClearITPendingBit(TIM4, TIM_IT_Update);
+	portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
@@ -0,0 +1,22 @@
+/**
+ * Gravity timer of the TETRIS game.
+ *
+ * TIM4 interrupts at gravityFrameRate, counts the frames the falling tetris
+ * falls by and gives frameReady to the refreshing task.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef gravity_timer_INCLUDED
+#define gravity_timer_INCLUDED
+
+#include <stdint.h>
+#include "tetris_gravity.h"
+
+extern SemaphoreHandle_t frameReady; // Binary semaphore given by every frame
+extern volatile uint32_t gravityFrames; // Frames since the timer started
+extern volatile uint32_t gravityMaxJitter; // Largest deviation from the frame period in TIM5 counts
+
+void gravityTimerInit();
+
+#endif
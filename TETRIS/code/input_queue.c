@@ -0,0 +1,66 @@
+/**
+ * Input event queue of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "includes.h"
+#include "input_queue.h"
+
+QueueHandle_t inputEvents;
+volatile uint32_t inputDrops = 0;
+volatile uint32_t inputMaxDepth = 0;
+uint32_t inputLatencyMax = 0;
+uint32_t inputLatencyCount = 0;
+uint32_t inputLatencySlow = 0;
+
+/*
+ * Function to create the input event queue
+ */
+void inputInit() {
+	inputEvents = xQueueCreate(inputQueueLength, sizeof(inputEvent));
+}
+
+/*
+ * Function to post an input event to the game from a task, returns 0 when the queue is full
+ */
+int inputPost(button privateButton, inputSource source) {
+	inputEvent event = {privateButton, source, TIM5->CNT};
+	if (xQueueSendToBack(inputEvents, &event, 0) != pdTRUE) {
+		inputDrops++;
+		return 0;
+	}
+	uint32_t depth = uxQueueMessagesWaiting(inputEvents);
+	if (depth > inputMaxDepth)
+		inputMaxDepth = depth;
+	return 1;
+}
+
+/*
+ * Function to post an input event to the game from an interrupt, returns 0 when the queue is full
+ */
+int inputPostFromISR(button privateButton, inputSource source, BaseType_t *higherPriorityTaskWoken) {
+	inputEvent event = {privateButton, source, TIM5->CNT};
+	if (xQueueSendToBackFromISR(inputEvents, &event, higherPriorityTaskWoken) != pdTRUE) {
+		inputDrops++;
+		return 0;
+	}
+	uint32_t depth = uxQueueMessagesWaitingFromISR(inputEvents);
+	if (depth > inputMaxDepth)
+		inputMaxDepth = depth;
+	return 1;
+}
+
+/*
+ * Function to measure the latency of a local button event when the game task takes it
+ */
+void inputMeasure(const inputEvent *event) {
+	if (event->source != inputLocal)
+		return;
+	uint32_t latency = TIM5->CNT - event->timestamp;
+	inputLatencyCount++;
+	if (latency > inputLatencyMax)
+		inputLatencyMax = latency;
+	if (latency > inputLatencyLimit)
+		inputLatencySlow++;
+}
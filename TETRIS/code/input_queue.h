@@ -0,0 +1,50 @@
+/**
+ * Input event queue of the TETRIS game.
+ *
+ * Every task and interrupt that has an input for the game posts an event with
+ * its button, its source and a timestamp of the free running TIM5 into one
+ * FreeRTOS queue, and gameStateManagement takes them in order. An event is only
+ * lost when the queue is full, which is counted in inputDrops.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef input_queue_INCLUDED
+#define input_queue_INCLUDED
+
+#include <stdint.h>
+#include "tetris_game.h"
+
+#define inputQueueLength 16
+#define inputLatencyLimit (configCPU_CLOCK_HZ / 2 / 1000) // 1 ms in TIM5 counts
+
+enum inputSource { // Origin of an input event
+	inputLocal, // Button of this board
+	inputBuddy, // Button of buddy's board
+	inputTimer, // Frame of the gravity timer
+	inputLink // Events or state of buddy's board received via UART
+};
+
+struct inputEvent {
+	uint8_t button;
+	uint8_t source;
+	uint32_t timestamp; // TIM5 count when the event was posted
+};
+
+typedef enum inputSource inputSource;
+typedef struct inputEvent inputEvent;
+
+extern QueueHandle_t inputEvents;
+extern volatile uint32_t inputDrops; // Events lost as the queue was full
+extern volatile uint32_t inputMaxDepth; // Most events waiting in the queue at once
+// Time from the edge of a local button to the game task taking its event, in TIM5 counts
+extern uint32_t inputLatencyMax;
+extern uint32_t inputLatencyCount;
+extern uint32_t inputLatencySlow; // Events taken later than inputLatencyLimit
+
+void inputInit();
+int inputPost(button privateButton, inputSource source);
+int inputPostFromISR(button privateButton, inputSource source, BaseType_t *higherPriorityTaskWoken);
+void inputMeasure(const inputEvent *event);
+
+#endif
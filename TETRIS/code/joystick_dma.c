@@ -0,0 +1,130 @@
+/**
+ * Analog joystick of the TETRIS game.
+ *
+ * The axes are on 2 ADCs, X on ADC3 and Y on ADC1, so each ADC converts its one
+ * channel on the TRGO event of TIM8 and has its own DMA2 stream: ADC1 on
+ * stream 0 channel 0, ADC3 on stream 1 channel 2. TIM8 is free on the board,
+ * TIM2 and TIM3 are left to the high speed timer test in Libraries/usr.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "includes.h"
+#include "joystick_dma.h"
+
+#define joystickTimerClock configCPU_CLOCK_HZ // APB2 timer clock
+#define joystickTimerPrescaler (joystickTimerClock / 1000000) // 1 MHz counter clock
+#define joystickInterruptPriority 6 // No FreeRTOS API in the interrupts
+
+struct joystickChannel {
+	ADC_TypeDef *adc;
+	uint8_t channel;
+	DMA_Stream_TypeDef *stream;
+	uint32_t dmaChannel;
+	uint8_t irq;
+};
+
+// In the order of the buffers, X and Y
+static const struct joystickChannel joystickChannels[2] = {
+	{ESPL_ADC_Joystick_1, ESPL_Channel_Joystick_1, DMA2_Stream1, DMA_Channel_2, DMA2_Stream1_IRQn},
+	{ESPL_ADC_Joystick_2, ESPL_Channel_Joystick_2, DMA2_Stream0, DMA_Channel_0, DMA2_Stream0_IRQn}
+};
+
+static volatile uint16_t joystickSamples[2][joystickBufferLength];
+tetrisJoystick joystickX, joystickY;
+
+/*
+ * Function to move the joystick ADCs, left converting continuously by gpioInit,
+ * to conversions triggered by TIM8 and transferred by DMA
+ */
+void joystickInit() {
+	TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+	ADC_InitTypeDef ADC_InitStructure;
+	DMA_InitTypeDef DMA_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	joystickAxisInit(&joystickX);
+	joystickAxisInit(&joystickY);
+	RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_DMA2, ENABLE);
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_TIM8, ENABLE);
+
+	ADC_StructInit(&ADC_InitStructure);
+	ADC_InitStructure.ADC_Resolution = ADC_Resolution_12b;
+	ADC_InitStructure.ADC_ScanConvMode = ENABLE;
+	ADC_InitStructure.ADC_ContinuousConvMode = DISABLE;
+	ADC_InitStructure.ADC_ExternalTrigConvEdge = ADC_ExternalTrigConvEdge_Rising;
+	ADC_InitStructure.ADC_ExternalTrigConv = ADC_ExternalTrigConv_T8_TRGO;
+	ADC_InitStructure.ADC_DataAlign = ADC_DataAlign_Right;
+	ADC_InitStructure.ADC_NbrOfConversion = 1;
+
+	DMA_StructInit(&DMA_InitStructure);
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+	DMA_InitStructure.DMA_BufferSize = joystickBufferLength;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+	DMA_InitStructure.DMA_FIFOMode = DMA_FIFOMode_Disable;
+
+	for (int n = 0; n < 2; n++) {
+		const struct joystickChannel *axis = &joystickChannels[n];
+		ADC_Cmd(axis->adc, DISABLE);
+		ADC_DMACmd(axis->adc, DISABLE);
+
+		DMA_DeInit(axis->stream);
+		DMA_InitStructure.DMA_Channel = axis->dmaChannel;
+		DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&axis->adc->DR;
+		DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)joystickSamples[n];
+		DMA_Init(axis->stream, &DMA_InitStructure);
+		DMA_ITConfig(axis->stream, DMA_IT_HT | DMA_IT_TC, ENABLE);
+		DMA_Cmd(axis->stream, ENABLE);
+
+		NVIC_InitStructure.NVIC_IRQChannel = axis->irq;
+		NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = joystickInterruptPriority;
+		NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+		NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+		NVIC_Init(&NVIC_InitStructure);
+
+		ADC_Init(axis->adc, &ADC_InitStructure);
+		ADC_RegularChannelConfig(axis->adc, axis->channel, 1, ADC_SampleTime_480Cycles);
+		ADC_DMARequestAfterLastTransferCmd(axis->adc, ENABLE); // Keep requesting in circular mode
+		ADC_DMACmd(axis->adc, ENABLE);
+		ADC_Cmd(axis->adc, ENABLE);
+	}
+
+	// TIM8 starts a conversion on every update
+	TIM_DeInit(TIM8);
+	TIM_TimeBaseStructInit(&TIM_TimeBaseStructure);
+	TIM_TimeBaseStructure.TIM_Prescaler = joystickTimerPrescaler - 1;
+	TIM_TimeBaseStructure.TIM_Period = joystickTimerClock / joystickTimerPrescaler / joystickSampleRate - 1;
+	TIM_TimeBaseStructure.TIM_ClockDivision = 0;
+	TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+	TIM_TimeBaseInit(TIM8, &TIM_TimeBaseStructure);
+	TIM_SelectOutputTrigger(TIM8, TIM_TRGOSource_Update);
+	TIM_Cmd(TIM8, ENABLE);
+}
+
+/*
+ * Function to filter the half of a buffer the DMA has just written
+ */
+static void joystickTransfer(int index, uint32_t halfFlag, uint32_t fullFlag, tetrisJoystick *axis) {
+	DMA_Stream_TypeDef *stream = joystickChannels[index].stream;
+	if (DMA_GetITStatus(stream, halfFlag) != RESET) {
+		DMA_ClearITPendingBit(stream, halfFlag);
+		joystickFilter(axis, (const uint16_t *)joystickSamples[index], joystickBufferLength / 2);
+	}
+	if (DMA_GetITStatus(stream, fullFlag) != RESET) {
+		DMA_ClearITPendingBit(stream, fullFlag);
+		joystickFilter(axis, (const uint16_t *)joystickSamples[index] + joystickBufferLength / 2, joystickBufferLength / 2);
+	}
+}
+
+void DMA2_Stream0_IRQHandler(void) {
+	joystickTransfer(1, DMA_IT_HTIF0, DMA_IT_TCIF0, &joystickY);
+}
+
+void DMA2_Stream1_IRQHandler(void) {
+	joystickTransfer(0, DMA_IT_HTIF1, DMA_IT_TCIF1, &joystickX);
+}
@@ -0,0 +1,27 @@
+/**
+ * Analog joystick of the TETRIS game.
+ *
+ * TIM8 triggers a conversion of both joystick axes at joystickSampleRate, and
+ * DMA2 moves the samples of every axis into its own circular buffer. The half
+ * and full transfer interrupts filter the half of the buffer just written in
+ * tetris_joystick, so no task ever reads an ADC register.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef joystick_dma_INCLUDED
+#define joystick_dma_INCLUDED
+
+#include "tetris_joystick.h"
+
+#define joystickSampleRate 1000 // Samples per second of every axis
+#define joystickBufferLength 32 // 2 blocks of 16 ms
+// Directions of the axes on the board, positive moves right and down
+#define joystickSignX 1
+#define joystickSignY -1
+
+extern tetrisJoystick joystickX, joystickY;
+
+void joystickInit();
+
+#endif
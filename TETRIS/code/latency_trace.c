@@ -0,0 +1,79 @@
+/**
+ * Input to photon latency of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "includes.h"
+#include "latency_trace.h"
+
+enum latencyPending { // Progress of the measured event
+	latencyIdle,
+	latencyTakenEvent,
+	latencyDrawnFrame
+};
+
+tetrisLatency latencyStats[latencyStages];
+const char *latencyStageNames[latencyStages] = {"queue", "draw", "swap", "total"};
+uint32_t latencyCoalesced = 0;
+static enum latencyPending latencyState = latencyIdle;
+static uint32_t latencyEdgeTime, latencyTakeTime, latencyDrawTime;
+static uint32_t latencySequence; // First snapshot showing the measured event
+
+/*
+ * Function to empty the histograms
+ */
+void latencyTraceInit() {
+	for (int n = 0; n < latencyStages; n++)
+		latencyInit(&latencyStats[n]);
+	latencyCoalesced = 0;
+	latencyState = latencyIdle;
+}
+
+/*
+ * Function to stamp a local button event as the game task takes it, sequence is
+ * the snapshot that will show it first
+ */
+void latencyTaken(const inputEvent *event, uint32_t sequence) {
+	if (event->source != inputLocal)
+		return;
+	uint32_t now = TIM5->CNT;
+	latencyAdd(&latencyStats[latencyQueue], now - event->timestamp);
+	taskENTER_CRITICAL(); // The render task stamps the same event
+	if (latencyState != latencyIdle) // The frame of the older event shows this one too
+		latencyCoalesced++;
+	else {
+		latencyEdgeTime = event->timestamp;
+		latencyTakeTime = now;
+		latencySequence = sequence;
+		latencyState = latencyTakenEvent;
+	}
+	taskEXIT_CRITICAL();
+}
+
+/*
+ * Function to stamp the frame of a snapshot as drawn, before waiting for the display
+ */
+void latencyDrawn(uint32_t sequence) {
+	taskENTER_CRITICAL();
+	if (latencyState == latencyTakenEvent && (int32_t)(sequence - latencySequence) >= 0) {
+		latencyDrawTime = TIM5->CNT;
+		latencyState = latencyDrawnFrame;
+	}
+	taskEXIT_CRITICAL();
+}
+
+/*
+ * Function to stamp the frame as presented to the display and add the stages of the event
+ */
+void latencySwapped() {
+	if (latencyState != latencyDrawnFrame)
+		return; // Only the render task moves on from a drawn frame
+	uint32_t now = TIM5->CNT;
+	latencyAdd(&latencyStats[latencyDraw], latencyDrawTime - latencyTakeTime);
+	latencyAdd(&latencyStats[latencySwap], now - latencyDrawTime);
+	latencyAdd(&latencyStats[latencyTotal], now - latencyEdgeTime);
+	taskENTER_CRITICAL();
+	latencyState = latencyIdle;
+	taskEXIT_CRITICAL();
+}
@@ -0,0 +1,43 @@
+/**
+ * Input to photon latency of the TETRIS game.
+ *
+ * A local button event carries the TIM5 count of its edge interrupt. The game
+ * task stamps it again as it takes the event, together with the sequence of the
+ * next snapshot it publishes. The render task stamps the first frame drawn from
+ * that snapshot or a newer one, and again when ESPL_DrawLayer presents it for
+ * the next vertical blank, which does not wait. Events taken before the
+ * frame is drawn are shown by it as well, so the oldest of them is measured. The time of every
+ * stage goes into a histogram of tetris_latency, drawn by K on the pause scene.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef latency_trace_INCLUDED
+#define latency_trace_INCLUDED
+
+#include <stdint.h>
+#include "tetris_latency.h"
+#include "input_queue.h"
+
+#define latencyCountsPerUs (configCPU_CLOCK_HZ / 2 / 1000000) // TIM5 counts per microsecond
+
+enum latencyStage {
+	latencyQueue, // Edge interrupt to the game task taking the event
+	latencyDraw, // Taking the event to the frame drawn
+	latencySwap, // Frame drawn to the frame presented
+	latencyTotal, // Edge interrupt to the frame presented
+	latencyStages
+};
+
+typedef enum latencyStage latencyStage;
+
+extern tetrisLatency latencyStats[latencyStages];
+extern const char *latencyStageNames[latencyStages];
+extern uint32_t latencyCoalesced; // Events shown by the frame of an older event
+
+void latencyTraceInit();
+void latencyTaken(const inputEvent *event, uint32_t sequence);
+void latencyDrawn(uint32_t sequence);
+void latencySwapped();
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * Glyph atlas of the side panels of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_atlas.h"
+#include <string.h>
+
+/*
+ * Function to get the glyph of a character, -1 for one outside the charset
+ */
+static int atlasGlyph(char c){
+	const char *found = c ? strchr(atlasCharset, c) : NULL;
+	return found ? (int)(found - atlasCharset) : -1;
+}
+
+/*
+ * Function to start an empty atlas in a strip of stride x height pixels
+ */
+void atlasInit(tetrisAtlas *atlas, uint16_t *pixels, int stride, int height, uint16_t key){
+	atlas->pixels = pixels;
+	atlas->stride = stride;
+	atlas->height = height;
+	atlas->used = 0;
+	atlas->key = key;
+	for (int glyph = 0; glyph < atlasGlyphs; glyph++){
+		atlas->advance[glyph] = -1;
+		atlas->offset[glyph] = 0;
+	}
+}
+
+/*
+ * Function to capture the glyph of c drawn at (x, y) onto the key color, which
+ * covers atlasBearing columns on both sides of its advance. Returns 0 if the
+ * character is outside the charset or the strip is full.
+ */
+int atlasCapture(tetrisAtlas *atlas, const tetrisSurface *surface, char c, int x, int y, int advance){
+	int glyph = atlasGlyph(c);
+	int width = advance + 2 * atlasBearing;
+	if (glyph < 0 || advance < 0 || atlas->used + width > atlas->stride)
+		return 0;
+	for (int row = 0; row < atlas->height; row++){
+		uint16_t *cell = atlas->pixels + row * atlas->stride + atlas->used;
+		for (int col = 0; col < width; col++){
+			int px = x - atlasBearing + col, py = y + row;
+			int inside = px >= 0 && px < surface->width && py >= 0 && py < surface->height;
+			cell[col] = inside ? *surfacePixel(surface, px, py) : atlas->key;
+		}
+	}
+	atlas->advance[glyph] = (int16_t)advance;
+	atlas->offset[glyph] = (int16_t)atlas->used;
+	atlas->used += width;
+	return 1;
+}
+
+/*
+ * Function to draw a string with its top left corner at (x, y) from the atlas,
+ * clipped to the surface. Draws nothing and returns 0 if a character of the
+ * string was not captured.
+ */
+int atlasDrawText(const tetrisAtlas *atlas, const tetrisSurface *surface, int x, int y, const char *text){
+	for (const char *c = text; *c; c++){
+		int glyph = atlasGlyph(*c);
+		if (glyph < 0 || atlas->advance[glyph] < 0)
+			return 0;
+	}
+	int rowStart = y < 0 ? -y : 0;
+	int rowEnd = y + atlas->height > surface->height ? surface->height - y : atlas->height;
+	for (; *text; text++){
+		int glyph = atlasGlyph(*text);
+		int left = x - atlasBearing, width = atlas->advance[glyph] + 2 * atlasBearing;
+		int colStart = left < 0 ? -left : 0;
+		int colEnd = left + width > surface->width ? surface->width - left : width;
+		const uint16_t *cell = atlas->pixels + atlas->offset[glyph];
+		if (surface->yStep == 1){ // Turned frame buffer, a column of the glyph is a row in memory
+			for (int col = colStart; col < colEnd; col++){
+				const uint16_t *source = cell + rowStart * atlas->stride + col;
+				uint16_t *target = surfacePixel(surface, left + col, y + rowStart);
+				for (int row = rowStart; row < rowEnd; row++, source += atlas->stride, target++)
+					if (*source != atlas->key)
+						*target = *source;
+			}
+		}
+		else {
+			for (int row = rowStart; row < rowEnd; row++){
+				const uint16_t *source = cell + row * atlas->stride;
+				uint16_t *target = surfacePixel(surface, left + colStart, y + row);
+				for (int col = colStart; col < colEnd; col++, target += surface->xStep)
+					if (source[col] != atlas->key)
+						*target = source[col];
+			}
+		}
+		x += atlas->advance[glyph];
+	}
+	return 1;
+}
@@ -0,0 +1,40 @@
+/**
+ * Glyph atlas of the side panels of the TETRIS game.
+ *
+ * The digits and the letters of the labels are drawn once by the font onto a
+ * background of the key color and captured from the frame buffer into a strip
+ * of RGB565 pixels, with atlasBearing columns on both sides of the advance for
+ * pixels reaching beyond it. The text of the panels is then drawn by copying
+ * the captured pixels which are not of the key color, the same pixels the font
+ * draws as it has no anti-aliasing, without decoding any glyph again.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_atlas_INCLUDED
+#define tetris_atlas_INCLUDED
+
+#include <stdint.h>
+#include "tetris_surface.h"
+
+#define atlasCharset "0123456789 SCORELVINXT" // Numbers and the labels SCORE, LEVEL, LINE and NEXT
+#define atlasGlyphs ((int)sizeof(atlasCharset) - 1)
+#define atlasBearing 4 // Columns captured on both sides of the advance of a glyph
+
+struct tetrisAtlas {
+	uint16_t *pixels; // Glyphs side by side, stride pixels a row
+	int stride;
+	int height; // Rows of every glyph, the height of the font
+	int used; // Columns taken by the glyphs captured
+	uint16_t key; // Background color of the capture, not copied
+	int16_t advance[atlasGlyphs]; // -1 for a glyph not captured
+	int16_t offset[atlasGlyphs]; // First column of every glyph
+};
+
+typedef struct tetrisAtlas tetrisAtlas;
+
+void atlasInit(tetrisAtlas *atlas, uint16_t *pixels, int stride, int height, uint16_t key);
+int atlasCapture(tetrisAtlas *atlas, const tetrisSurface *surface, char c, int x, int y, int advance);
+int atlasDrawText(const tetrisAtlas *atlas, const tetrisSurface *surface, int x, int y, const char *text);
+
+#endif
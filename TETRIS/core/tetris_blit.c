@@ -0,0 +1,94 @@
+/**
+ * Batches of tile blits into the frame buffers of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_blit.h"
+
+/*
+ * Function to run a blit on the CPU, line by line like the DMA2D
+ */
+void blitRun(const tetrisBlit *blit){
+	const uint16_t *input = blit->input;
+	uint16_t *output = blit->output;
+	for (int line = 0; line < blit->lines; line++, input += blit->inputOffset, output += blit->outputOffset)
+		for (int n = 0; n < blit->length; n++)
+			*output++ = *input++;
+}
+
+static void blitSoftwareStart(void *context, const tetrisBlit *blits, int count){
+	(void)context;
+	for (int n = 0; n < count; n++)
+		blitRun(&blits[n]);
+}
+
+static void blitSoftwareWait(void *context){
+	(void)context;
+}
+
+/*
+ * Function to set up an empty queue running its batches on the CPU, without a clock
+ */
+void blitSoftwareInit(tetrisBlitQueue *queue){
+	queue->count = 0;
+	queue->context = NULL;
+	queue->start = blitSoftwareStart;
+	queue->wait = blitSoftwareWait;
+	queue->clock = NULL;
+	queue->batches = 0;
+	queue->blitCount = 0;
+	queue->busy = 0;
+}
+
+/*
+ * Function to queue the blit of a tile with its top left corner at (x, y),
+ * clipped to the surface. The tile is read when the batch runs. Returns 0 if
+ * nothing is left to blit.
+ */
+int blitTile(tetrisBlitQueue *queue, const tetrisSurface *surface, int x, int y, const tetrisSurface *tile){
+	int x0 = x < 0 ? 0 : x, y0 = y < 0 ? 0 : y;
+	int x1 = x + tile->width > surface->width ? surface->width : x + tile->width;
+	int y1 = y + tile->height > surface->height ? surface->height : y + tile->height;
+	surfaceLines input, output;
+	if (!surfaceClip(surface, x0, y0, x1 - x0, y1 - y0, &output)
+			|| !surfaceClip(tile, x0 - x, y0 - y, x1 - x0, y1 - y0, &input))
+		return 0;
+	if (queue->count == blitQueueLength)
+		blitFlush(queue);
+	tetrisBlit *blit = &queue->blits[queue->count++];
+	blit->input = tile->origin + input.first;
+	blit->output = surface->origin + output.first;
+	blit->length = output.length;
+	blit->lines = output.lines;
+	blit->inputOffset = input.step - input.length;
+	blit->outputOffset = output.step - output.length;
+	return 1;
+}
+
+/*
+ * Function to start the blits queued as a batch
+ */
+void blitFlush(tetrisBlitQueue *queue){
+	if (!queue->count)
+		return;
+	uint32_t start = queue->clock ? queue->clock() : 0;
+	queue->start(queue->context, queue->blits, queue->count);
+	if (queue->clock)
+		queue->busy += (uint32_t)(queue->clock() - start);
+	queue->batches++;
+	queue->blitCount += (uint32_t)queue->count;
+	queue->count = 0;
+}
+
+/*
+ * Function to start the blits queued and wait for all of them, before the CPU
+ * touches their pixels
+ */
+void blitWait(tetrisBlitQueue *queue){
+	blitFlush(queue);
+	uint32_t start = queue->clock ? queue->clock() : 0;
+	queue->wait(queue->context);
+	if (queue->clock)
+		queue->busy += (uint32_t)(queue->clock() - start);
+}
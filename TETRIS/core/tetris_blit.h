@@ -0,0 +1,54 @@
+/**
+ * Batches of tile blits into the frame buffers of the TETRIS game.
+ *
+ * A blit is described the way the memory to memory mode of the DMA2D takes
+ * it: the first pixel of the input and of the output, the pixels of a line,
+ * the lines, and the pixels skipped between 2 lines in the input and in the
+ * output. blitTile clips a tile, a small surface in the layout of the frame
+ * buffer, to the target surface and queues its blit. The queued blits are
+ * handed to the engine as a single batch when the queue is full or flushed,
+ * and the engine runs them in order. The software engine runs them on the CPU
+ * at once, the DMA2D engine of the board starts the first one and each
+ * transfer complete interrupt starts the next, so the render task waits once
+ * for the whole batch. An engine keeps its own copy of a batch started, the
+ * queue takes new blits at once.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_blit_INCLUDED
+#define tetris_blit_INCLUDED
+
+#include <stdint.h>
+#include "tetris_surface.h"
+
+#define blitQueueLength 64 // Blits of a batch, the next tetris and the cells of a few rows
+
+struct tetrisBlit {
+	const uint16_t *input; // First pixel, lowest in memory
+	uint16_t *output;
+	int length, lines;
+	int inputOffset, outputOffset; // Pixels skipped between 2 lines
+};
+
+struct tetrisBlitQueue {
+	struct tetrisBlit blits[blitQueueLength];
+	int count; // Blits queued and not started
+	void *context;
+	void (*start)(void *context, const struct tetrisBlit *blits, int count); // Starts a batch after the ones started before
+	void (*wait)(void *context); // Returns when all batches started are done
+	uint32_t (*clock)(void); // Counter of the CPU time, NULL for none
+	uint32_t batches, blitCount; // Batches and blits started
+	uint64_t busy; // Clock counts spent in starting batches and waiting for them
+};
+
+typedef struct tetrisBlit tetrisBlit;
+typedef struct tetrisBlitQueue tetrisBlitQueue;
+
+void blitRun(const tetrisBlit *blit);
+void blitSoftwareInit(tetrisBlitQueue *queue);
+int blitTile(tetrisBlitQueue *queue, const tetrisSurface *surface, int x, int y, const tetrisSurface *tile);
+void blitFlush(tetrisBlitQueue *queue);
+void blitWait(tetrisBlitQueue *queue);
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * Row-mask playfield of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_board.h"
+#include <string.h>
+
+/*
+ * Function to empty the whole playfield and set up the wall and floor sentinels
+ */
+void boardClear(tetrisBoard *board){
+	for (int row = 0; row < boardStorageRows; row++)
+		board->rows[row] = row < boardHiddenRows + boardHeight ? boardWallMask : boardFullRow;
+	memset(board->color, 0, sizeof(board->color));
+	memset(board->height, boardHeight, sizeof(board->height));
+}
+
+/*
+ * Function to recompute the stack height of every column from the row masks
+ */
+void boardUpdateHeights(tetrisBoard *board){
+	uint16_t pending = boardFieldMask; // Columns whose highest block is not found yet
+	memset(board->height, boardHeight, sizeof(board->height));
+	for (int row = 0; row < boardHeight && pending; row++){
+		uint16_t found = boardRow(board, row) & pending;
+		pending &= (uint16_t)~found;
+		while (found){
+			board->height[__builtin_ctz(found) - boardWallBits] = (uint8_t)row;
+			found &= found - 1;
+		}
+	}
+}
+
+/*
+ * Function to get which of the given rows are completely filled.
+ * A tetris can only complete the rows it is fixed in, so only those are passed.
+ */
+uint32_t boardFullRows(const tetrisBoard *board, uint32_t rowSet){
+	uint32_t fullRows = 0;
+	rowSet &= (1u << boardHeight) - 1;
+	while (rowSet){
+		int row = __builtin_ctz(rowSet);
+		if (boardRowFull(board, row))
+			fullRows |= 1u << row;
+		rowSet &= rowSet - 1;
+	}
+	return fullRows;
+}
+
+/*
+ * Function to empty a set of rows without moving the others
+ */
+void boardClearRows(tetrisBoard *board, uint32_t rowSet){
+	for (int row = 0; row < boardHeight; row++){
+		if (rowSet & (1u << row)){
+			board->rows[row + boardHiddenRows] = boardWallMask;
+			memset(board->color[row], 0, boardWidth);
+		}
+	}
+	boardUpdateHeights(board);
+}
+
+/*
+ * Function to delete a set of rows and let the remaining rows fall down in a single pass
+ */
+void boardRemoveRows(tetrisBoard *board, uint32_t rowSet){
+	if (!rowSet)
+		return;
+	int dst = 31 - __builtin_clz(rowSet); // Rows below the lowest removed row stay in place
+	if (!(rowSet & (rowSet - 1))){ // A single row, the rows above it fall by one in 2 block moves
+		memmove(&board->rows[boardHiddenRows + 1], &board->rows[boardHiddenRows], dst * sizeof(board->rows[0]));
+		memmove(board->color[1], board->color[0], dst * boardWidth);
+		board->rows[boardHiddenRows] = boardWallMask;
+	}
+	else {
+		for (int src = dst; src >= 0; src--){ // Copy surviving rows from bottom to top
+			if (rowSet & (1u << src))
+				continue;
+			if (dst != src){
+				board->rows[dst + boardHiddenRows] = board->rows[src + boardHiddenRows];
+				memcpy(board->color[dst], board->color[src], boardWidth);
+			}
+			dst--;
+		}
+		for (; dst >= 0; dst--) // Rows on top of the stack become empty
+			board->rows[dst + boardHiddenRows] = boardWallMask;
+	}
+	boardUpdateHeights(board);
+}
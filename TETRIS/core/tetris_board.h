@@ -0,0 +1,99 @@
+/**
+ * Row-mask playfield of the TETRIS game.
+ *
+ * Every row of the playfield is stored as one bit mask, so collision, full-line
+ * tests and line shifts are AND/compare operations on a single word instead of
+ * loops over 10 cells. The masks are padded with sentinels: two permanently set
+ * wall bits on the left and four on the right of the 10 columns, hidden rows
+ * above row 0 where a tetris may reach right after spawning, and solid floor
+ * rows below the last row. Any tetris position reachable by one move or
+ * rotation from a valid one therefore stays inside the stored masks, and a
+ * collision test needs no bounds checks.
+ *
+ * The color of each occupied cell is kept in a separate unpadded plane that is
+ * only read when drawing. The height of the stack in every column is cached so
+ * drop distances need no search.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_board_INCLUDED
+#define tetris_board_INCLUDED
+
+#include <stdint.h>
+
+#define boardHeight 20
+#define boardWidth 10
+#define boardHiddenRows 2 // Rows above row 0, a tetris centered at row 0 reaches row -2
+#define boardFloorRows 2 // Solid rows below the last row
+#define boardStorageRows (boardHiddenRows + boardHeight + boardFloorRows)
+#define boardWallBits 2 // Bit of column 0 in a row mask
+#define boardFieldMask ((uint16_t)(((1u << boardWidth) - 1) << boardWallBits)) // Cells of the 10 columns
+#define boardWallMask ((uint16_t)~boardFieldMask) // Wall sentinels on both sides
+#define boardFullRow ((uint16_t)0xFFFF) // Mask of a row without any empty cell, walls included
+
+struct tetrisBoard {
+	uint16_t rows[boardStorageRows]; // Padded occupancy masks, use boardRow() to index by playfield row
+	uint8_t color[boardHeight][boardWidth]; // Color index of each occupied cell
+	uint8_t height[boardWidth]; // Highest occupied row of each column, boardHeight for an empty column
+};
+
+typedef struct tetrisBoard tetrisBoard;
+
+void boardClear(tetrisBoard *board);
+void boardUpdateHeights(tetrisBoard *board);
+
+// Line clearing on a bit set of rows, bit n = row n
+uint32_t boardFullRows(const tetrisBoard *board, uint32_t rowSet);
+void boardClearRows(tetrisBoard *board, uint32_t rowSet);
+void boardRemoveRows(tetrisBoard *board, uint32_t rowSet);
+
+/*
+ * Row mask of a playfield row, valid from -boardHiddenRows to boardHeight + boardFloorRows - 1
+ */
+static inline uint16_t boardRow(const tetrisBoard *board, int y){
+	return board->rows[y + boardHiddenRows];
+}
+
+/*
+ * Cell and row tests are called several times per input event, so they are inlined.
+ * Hidden rows are free, wall columns and floor rows are occupied by the sentinels.
+ * Only cells inside the padding can be tested.
+ */
+static inline int boardCellFree(const tetrisBoard *board, int x, int y){
+	return !(boardRow(board, y) & (1u << (x + boardWallBits)));
+}
+
+/*
+ * Blocks are only stored inside the 10x20 playfield, a tetris fixed above it ends the game
+ */
+static inline void boardSetCell(tetrisBoard *board, int x, int y, uint8_t colorNum){
+	if ((unsigned)x >= boardWidth || (unsigned)y >= boardHeight)
+		return;
+	board->rows[y + boardHiddenRows] |= (uint16_t)(1u << (x + boardWallBits));
+	board->color[y][x] = colorNum;
+	if (y < board->height[x])
+		board->height[x] = (uint8_t)y;
+}
+
+static inline void boardClearCell(tetrisBoard *board, int x, int y){
+	if ((unsigned)x >= boardWidth || (unsigned)y >= boardHeight)
+		return;
+	board->rows[y + boardHiddenRows] &= (uint16_t)~(1u << (x + boardWallBits)); // The stale color is never read for an empty cell
+	if (y == board->height[x])
+		boardUpdateHeights(board);
+}
+
+static inline uint8_t boardGetColor(const tetrisBoard *board, int x, int y){
+	return boardCellFree(board, x, y) ? 0 : board->color[y][x];
+}
+
+static inline int boardRowFull(const tetrisBoard *board, int row){
+	return boardRow(board, row) == boardFullRow;
+}
+
+static inline int boardRowCount(uint32_t rowSet){
+	return __builtin_popcount(rowSet);
+}
+
+#endif
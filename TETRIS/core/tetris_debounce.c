@@ -0,0 +1,48 @@
+/**
+ * Debouncing of the buttons of the TETRIS game by edge timestamps.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_debounce.h"
+
+/*
+ * Function to start with all buttons released
+ */
+void debounceInit(tetrisDebounce *debounce, uint32_t debounceTime){
+	debounce->debounceTime = debounceTime;
+	for (int n = 0; n < debounceButtons; n++){
+		debounce->lastEdge[n] = 0;
+		debounce->lastLevel[n] = 1;
+		debounce->quiet[n] = 1;
+	}
+	debounce->edges = 0;
+	debounce->presses = 0;
+}
+
+/*
+ * Function to handle an edge of a button pin with the level read after it,
+ * returns 1 when the edge is a new press
+ */
+int debounceEdge(tetrisDebounce *debounce, int index, int level, uint32_t now){
+	if (index < 0 || index >= debounceButtons)
+		return 0;
+	int quiet = debounce->quiet[index] || now - debounce->lastEdge[index] >= debounce->debounceTime;
+	int press = level == 0 && debounce->lastLevel[index] && quiet; // Falling edge after a stable release
+	debounce->lastEdge[index] = now;
+	debounce->lastLevel[index] = level != 0;
+	debounce->quiet[index] = 0;
+	debounce->edges++;
+	debounce->presses += press;
+	return press;
+}
+
+/*
+ * Function to mark the pins quiet for the debounce time, called more often
+ * than the timestamps wrap
+ */
+void debounceTick(tetrisDebounce *debounce, uint32_t now){
+	for (int n = 0; n < debounceButtons; n++)
+		if (now - debounce->lastEdge[n] >= debounce->debounceTime)
+			debounce->quiet[n] = 1;
+}
@@ -0,0 +1,48 @@
+/**
+ * Debouncing of the buttons of the TETRIS game by edge timestamps.
+ *
+ * The button interrupts hand every edge of a pin with its level after the
+ * edge and a timestamp. A press is taken on its first falling edge, as long as
+ * the pin was released and quiet for the debounce time before it, so a press
+ * costs no waiting. Every further edge of the bouncing contact comes within
+ * the debounce time of the edge before and is ignored, the same for the bounces
+ * of a release. No timer is needed to find the end of a bounce, the next edge
+ * tells how long the pin was quiet.
+ *
+ * Timestamps are in any unit counting up and wrapping at 2^32, the interrupts
+ * use the free running timer. A periodic debounceTick marks the pins quiet for
+ * longer than a wrap of the timestamps.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_debounce_INCLUDED
+#define tetris_debounce_INCLUDED
+
+#include <stdint.h>
+
+#define debounceButtons 6 // Button A to E and K
+
+struct tetrisDebounce {
+	uint32_t debounceTime; // Quiet time of a pin before a press is taken
+	uint32_t lastEdge[debounceButtons]; // Timestamp of the last edge of every pin
+	uint8_t lastLevel[debounceButtons]; // Level after the last edge, 0 is pressed
+	uint8_t quiet[debounceButtons]; // No edge since the start, the pin counts as quiet
+	uint32_t edges; // Edges handed in
+	uint32_t presses; // Presses taken
+};
+
+typedef struct tetrisDebounce tetrisDebounce;
+
+void debounceInit(tetrisDebounce *debounce, uint32_t debounceTime);
+int debounceEdge(tetrisDebounce *debounce, int index, int level, uint32_t now);
+void debounceTick(tetrisDebounce *debounce, uint32_t now);
+
+/*
+ * Function to check if a button is held down after its last edge
+ */
+static inline int debounceHeld(const tetrisDebounce *debounce, int index){
+	return index >= 0 && index < debounceButtons && !debounce->lastLevel[index];
+}
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * Rectangle fills of the frame buffers of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_fill.h"
+
+/*
+ * Function to run a fill on the CPU, pixel by pixel like the DMA2D
+ */
+void fillRun(const tetrisFill *fill){
+	uint16_t *pixel = fill->output;
+	for (int line = 0; line < fill->lines; line++, pixel += fill->offset)
+		for (int n = 0; n < fill->length; n++)
+			*pixel++ = fill->color;
+}
+
+static void fillSoftwareStart(void *context, const tetrisFill *fill){
+	(void)context;
+	fillRun(fill);
+}
+
+static void fillSoftwareWait(void *context){
+	(void)context;
+}
+
+/*
+ * Function to set up the engine running the fills on the CPU, without a clock
+ */
+void fillSoftwareInit(tetrisFillEngine *engine){
+	engine->context = NULL;
+	engine->start = fillSoftwareStart;
+	engine->wait = fillSoftwareWait;
+	engine->clock = NULL;
+	engine->fills = 0;
+	engine->pixels = 0;
+	engine->busy = 0;
+}
+
+/*
+ * Function to fill a rectangle of a surface, clipped to it. Returns 0 if
+ * nothing is left to fill.
+ */
+int fillRect(tetrisFillEngine *engine, const tetrisSurface *surface, int x, int y, int cx, int cy, uint16_t color){
+	surfaceLines lines;
+	if (!surfaceClip(surface, x, y, cx, cy, &lines))
+		return 0;
+	tetrisFill fill = {surface->origin + lines.first, lines.length, lines.lines, lines.step - lines.length, color};
+	uint32_t start = engine->clock ? engine->clock() : 0;
+	engine->start(engine->context, &fill);
+	if (engine->clock)
+		engine->busy += (uint32_t)(engine->clock() - start);
+	engine->fills++;
+	engine->pixels += (uint64_t)lines.length * lines.lines;
+	return 1;
+}
+
+/*
+ * Function to wait for the fills started, before the CPU touches their pixels
+ */
+void fillWait(tetrisFillEngine *engine){
+	uint32_t start = engine->clock ? engine->clock() : 0;
+	engine->wait(engine->context);
+	if (engine->clock)
+		engine->busy += (uint32_t)(engine->clock() - start);
+}
@@ -0,0 +1,51 @@
+/**
+ * Rectangle fills of the frame buffers of the TETRIS game.
+ *
+ * A fill is described the way the register to memory mode of the DMA2D takes
+ * it: the first pixel, the pixels of a line, the lines, the pixels skipped from
+ * the end of a line to the start of the next one, and the color. The DMA2D
+ * takes up to 16383 pixels a line, whole lines are never merged into one.
+ * fillRect turns a rectangle of a surface into such a fill and hands it to a
+ * fill engine. The software engine runs it on the CPU at once, the DMA2D
+ * engine of the board starts it and returns while the fill goes on. Before
+ * the CPU touches pixels a fill may still write, fillWait returns when all
+ * fills started are done.
+ *
+ * An engine with a clock counts the time the CPU spends in starting fills and
+ * in waiting for them, which is the whole fill for the software engine.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_fill_INCLUDED
+#define tetris_fill_INCLUDED
+
+#include <stdint.h>
+#include "tetris_surface.h"
+
+struct tetrisFill {
+	uint16_t *output; // First pixel, lowest in memory
+	int length, lines;
+	int offset; // Pixels skipped between 2 lines
+	uint16_t color;
+};
+
+struct tetrisFillEngine {
+	void *context;
+	void (*start)(void *context, const struct tetrisFill *fill); // Starts a fill after the ones started before
+	void (*wait)(void *context); // Returns when all fills started are done
+	uint32_t (*clock)(void); // Counter of the CPU time, NULL for none
+	uint32_t fills; // Fills started
+	uint64_t pixels;
+	uint64_t busy; // Clock counts spent in starting fills and waiting for them
+};
+
+typedef struct tetrisFill tetrisFill;
+typedef struct tetrisFillEngine tetrisFillEngine;
+
+void fillRun(const tetrisFill *fill);
+void fillSoftwareInit(tetrisFillEngine *engine);
+int fillRect(tetrisFillEngine *engine, const tetrisSurface *surface, int x, int y, int cx, int cy, uint16_t color);
+void fillWait(tetrisFillEngine *engine);
+
+#endif
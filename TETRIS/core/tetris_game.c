@@ -0,0 +1,466 @@
+/**
+ * Game logic of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_game.h"
+#include "tetris_shape.h"
+
+// Score setting rule, by number of eliminated lines and level
+static const int score_add[maxLineDisappear][levelNum] = {
+	{40, 80, 120, 160},
+	{100, 200, 300, 400},
+	{300, 600, 900, 1200},
+	{1200, 2500, 3600, 4800}
+};
+
+/*
+ * Gravity of the game level, the speed of the game mode scales the gravity of single mode
+ */
+static uint32_t gameGravityRate(const tetrisGame *game){
+	int level = game->level < gravityLevels ? game->level : gravityLevels - 1;
+	if (game->speed <= 0)
+		return gravityTable[level];
+	return (uint32_t)((uint64_t)gravityTable[level] * singleModeSpeed / (uint32_t)game->speed);
+}
+
+/*----------------------------------------Game State----------------------------------------*/
+/*
+ * Function to go back to the main menu settings
+ */
+void gameReset(tetrisGame *game){
+	game->level = 0;
+	game->mode = modeSelect;
+}
+
+/*
+ * Function to initialize game setting before starting the game with the tetris sequence of a seed
+ */
+void gameStart(tetrisGame *game, uint32_t seed){
+	game->score = 0;
+	game->lines = 0;
+	game->pieces = 0;
+	game->isGameOver = 0;
+	game->startLevel = game->level;
+	gravityInit(&game->gravity, gameGravityRate(game), gravityLockFrames);
+	game->seed = seed;
+	bagSeed(&game->bag, seed);
+	tetrisInit(&game->current, &game->bag);
+	tetrisInit(&game->next, &game->bag);
+	clearMap(&game->board);
+	if (game->gravity20G && game->mode == singlePlayer)
+		tetrisDrop(&game->current, &game->board);
+}
+
+/*
+ * Function to get the next game state based on current state
+ */
+currentState getState(tetrisGame *game, currentState state, button privateButton) {
+	switch(state){
+	case gameMenu:{
+		if (privateButton == A){ // Start single mode
+			game->mode = singlePlayer;
+			game->speed = singleModeSpeed;
+			return initGame;
+		}
+		if (privateButton == C && game->connected){ // Start double mode only when 2 boards are connected
+			game->mode = doublePlayerSelect;
+			game->speed = doubleModeSpeed;
+			return selectMenu;
+		}
+		else { // Set game level from 0 to 3
+			if (privateButton == B && game->level < 3)
+				game->level++;
+			else if (privateButton == D && game->level > 0)
+				game->level--;
+			else if (privateButton == K) // Toggle 20G gravity
+				game->gravity20G = !game->gravity20G;
+			return gameMenu;
+		}
+		break;
+	}
+	case selectMenu:
+	{
+		if (!game->connected)
+		{
+			gameReset(game);
+			return gameMenu;
+		}
+		if (privateButton == A) {
+			if (game->buddyA)
+				game->mode = doublePlayerRotate;
+			else
+				game->mode = doublePlayerMove;
+			return initGame;
+		}
+
+		if (privateButton == C) {
+			if (game->buddyC)
+				game->mode = doublePlayerMove;
+			else
+				game->mode = doublePlayerRotate;
+			return initGame;
+		}
+		else { // Set game level from 0 to 3
+			if (privateButton == B && game->level < 3)
+				game->level++;
+			else if (privateButton == D && game->level > 0)
+				game->level--;
+			return selectMenu;
+		}
+		break;
+	}
+	case initGame:{
+		if (!game->connected && (game->mode == doublePlayerMove || game->mode == doublePlayerRotate))
+		{
+			gameReset(game);
+			return gameMenu;
+		}
+		return inGame;
+		break;
+	}
+	case inGame:{
+		if (!game->connected && (game->mode == doublePlayerMove || game->mode == doublePlayerRotate)) {
+			gameReset(game);
+			return gameMenu;
+		}
+		if (privateButton == system_refresh) // No operation
+			return nextRound;
+		if (privateButton == A || privateButton == B ||privateButton == C || privateButton == D) // Move and rotate tetris
+			return inGame;
+		if (privateButton == E) // Pause the game
+			return gamePause;
+		if (privateButton == K) // Hard drop fixes the tetris in the next round
+			return nextRound;
+		break;
+	}
+	case gamePause:{
+		if (!game->connected && (game->mode == doublePlayerMove || game->mode == doublePlayerRotate)) {
+			gameReset(game);
+			return gameMenu;
+		}
+		if (privateButton == D) {
+			if (game->mode == doublePlayerMove)
+				return nextRound;
+			return inGame; // Resume the game if D is pressed
+		}
+		else if (privateButton == B)
+			return gameOver; // End the game if B is pressed
+		else if (privateButton == A)
+			return initGame; // Restart the game if A is pressed
+		return gamePause; // The system remain in the pause scene waiting for the input if no operation is executed
+		break;
+	}
+	case nextRound:{
+		if (game->isGameOver)
+			return gameOver;
+		else {
+			if (!game->connected && (game->mode == doublePlayerMove || game->mode == doublePlayerRotate)) {
+				gameReset(game);
+				return gameMenu;
+			}
+			if (game->mode == doublePlayerMove) {
+				if (privateButton == E) // Pause the game
+					return gamePause;
+				return nextRound;
+			}
+			if (privateButton == K) // Hard drop fixes the tetris in this round
+				return nextRound;
+			return inGame;
+		}
+		break;
+	}
+	case gameOver:{
+		if (privateButton != system_refresh) { // Press any button to exit to menu
+			gameReset(game);
+			return gameMenu;
+		}
+		else
+			return gameOver;
+		break;
+	}
+	}
+	return state;
+}
+
+/*----------------------------------------Game Operations----------------------------------------*/
+/*
+ * Function to move or rotate the falling tetris by a button during the game
+ */
+void gameInput(tetrisGame *game, button privateButton){
+	switch(privateButton){
+	case A:{ // Rotate counterclockwise
+		tetrisRotate(&game->current, &game->board);
+		break;
+	}
+	case B:{ // Move right
+		tetrisMove(&game->current, right, &game->board);
+		break;
+	}
+	case C:{ // Move down
+		tetrisMove(&game->current, down, &game->board);
+		break;
+	}
+	case D:{ // Move left
+		tetrisMove(&game->current, left, &game->board);
+		break;
+	}
+	default:
+		break;
+	}
+	if (game->gravity20G && game->mode == singlePlayer) // Slide along the surface of the stack
+		tetrisDrop(&game->current, &game->board);
+}
+
+/*
+ * Function to run a round of gravity: the falling tetris moves 1 row down, or
+ * straight to its landing position for a hard drop (K). When it cannot move it
+ * is fixed, the next tetris appears and full lines are eliminated.
+ * Returns the eliminated rows (bit n = row n).
+ */
+uint32_t gameRound(tetrisGame *game, button privateButton){
+	if (privateButton == K)
+		tetrisDrop(&game->current, &game->board);
+	if (!checkNewTetris(&game->current, &game->board))
+		return 0;
+	uint32_t lockedRows = gameLockTetris(game);
+	gameNextTetris(game);
+	uint32_t fullLines = checkFullLine(lockedRows, &game->board);
+	gameAddLines(game, boardRowCount(fullLines));
+	letLineDisappear(fullLines, &game->board);
+	return fullLines;
+}
+
+/*
+ * Function to let the falling tetris fall by the gravity of the frames passed
+ * since the last call, the rows it falls are added to rows. A tetris resting on
+ * the stack is fixed after the lock delay, which restarts whenever the tetris
+ * gets lower than before.
+ * Returns 1 when the tetris has to be fixed now.
+ */
+int gameGravity(tetrisGame *game, int frames, int *rows){
+	tetrisGravity *gravity = &game->gravity;
+	tetrisBlock *tetris = &game->current;
+	int cells = gravityAdvance(gravity, frames);
+	int fallen = 0;
+	while (fallen < cells && tetrisMove(tetris, down, &game->board))
+		fallen++;
+	if (rows)
+		*rows += fallen;
+
+	if (gravity->pieces != game->pieces || tetris->center.y > gravity->lowestY){ // New tetris or lower than before
+		gravity->pieces = game->pieces;
+		gravity->lowestY = tetris->center.y;
+		gravity->lockTimer = gravity->lockFrames;
+		frames = 0;
+	}
+	if (shapeFits(&game->board, tetris->type, tetris->center.x, tetris->center.y + 1))
+		return 0;
+	gravity->fraction = 0; // No gravity builds up while resting
+	gravity->lockTimer -= frames;
+	return gravity->lockTimer <= 0;
+}
+
+/*
+ * Function to move the falling tetris by a held button (B, C or D) up to moves
+ * cells, stopping at the wall or the stack. Returns the cells moved.
+ */
+int gameShift(tetrisGame *game, button privateButton, int moves){
+	direction direct = privateButton == B ? right : privateButton == D ? left : down;
+	int moved = 0;
+	while (moved < moves && tetrisMove(&game->current, direct, &game->board))
+		moved++;
+	if (moved && game->gravity20G && game->mode == singlePlayer) // Slide along the surface of the stack
+		tetrisDrop(&game->current, &game->board);
+	return moved;
+}
+
+/*
+ * Function to fix the falling tetris on the map, returns the rows it covers (bit n = row n)
+ */
+uint32_t gameLockTetris(tetrisGame *game){
+	printTetrisOnMap(&game->current, &game->board);
+	game->pieces++;
+	game->isGameOver = checkGameOver(&game->current);
+	return getRows(&game->current);
+}
+
+/*
+ * Function to change current tetris to next tetris and generate a new next tetris
+ */
+void gameNextTetris(tetrisGame *game){
+	copyTetris(&game->current, &game->next);
+	tetrisInit(&game->next, &game->bag);
+	if (game->gravity20G && game->mode == singlePlayer)
+		tetrisDrop(&game->current, &game->board);
+}
+
+/*
+ * Function to refresh score, lines and level after eliminating full lines
+ */
+void gameAddLines(tetrisGame *game, int lineNum){
+	if (lineNum <= 0)
+		return;
+	game->score += score_add[lineNum-1][game->level < levelNum ? game->level : levelNum - 1];
+	game->lines += lineNum;
+	game->level = game->startLevel + game->lines/5; // Automatic increase of level
+	if (game->level > gravityLevels - 1)
+		game->level = gravityLevels - 1;
+	game->gravity.cellsPerFrame = gameGravityRate(game);
+}
+
+/*----------------------------------------Tetris Operations----------------------------------------*/
+/*
+ * Function to check whether a new tetris should appear and start the new round
+ */
+int checkNewTetris(tetrisBlock *tetrisPtr, tetrisBoard *board){
+	if (!tetrisMove(tetrisPtr, down, board))
+		return 1; // Need next tetris
+	else return 0;
+}
+
+/*
+ * Function to check full lines to be eliminated among the rows of the fixed tetris,
+ * returns the set of full rows (bit n = row n)
+ */
+uint32_t checkFullLine(uint32_t lockedRows, tetrisBoard *board){
+	uint32_t fullLines = boardFullRows(board, lockedRows);
+	boardClearRows(board, fullLines); // Eliminate the target lines
+	return fullLines;
+}
+
+/*
+ * Function to move remaining tetris blocks down after eliminating full lines
+ */
+void letLineDisappear(uint32_t fullLines, tetrisBoard *board){
+	boardRemoveRows(board, fullLines);
+}
+
+/*
+ * Function to check whether the game is over
+ */
+int checkGameOver(tetrisBlock *blockPtr){
+	int isGameOver = 0;
+	for (int i = 0; i < 4; i++){
+		if (blockPtr->position[i].y == 0){
+			isGameOver = 1;
+			break;
+		}
+	}
+	return isGameOver;
+}
+
+/*
+ * Function to clear the fixed tetris on the block map
+ */
+void clearMap(tetrisBoard *board){
+	boardClear(board);
+}
+
+/*
+ * Function to clear the record of coordinates of current tetris in order to get ready for recording the next ones
+ */
+void clearTetrisPosition(tetrisBlock* blockPtr, tetrisBoard *board){
+	for (int i = 0; i < 4; i++)
+		boardClearCell(board, blockPtr->position[i].x, blockPtr->position[i].y);
+}
+
+/*
+ * Function to draw the fixed tetris block on the map when current tetris block stops moving
+ */
+void printTetrisOnMap(tetrisBlock *blockPtr, tetrisBoard *board){
+	// Build fixed tetris
+	for (int i = 0; i < 4; i++)
+		boardSetCell(board, blockPtr->position[i].x, blockPtr->position[i].y, blockPtr->color_num);
+}
+
+/*
+ * Function to get the set of rows covered by current tetris (bit n = row n)
+ */
+uint32_t getRows(tetrisBlock* blockPtr) {
+	return shapeRows(blockPtr->type, blockPtr->center.y);
+}
+
+/*
+ * Function to move next tetris to current one
+ */
+void copyTetris(tetrisBlock *currentTetris, tetrisBlock *nextTetris) {
+	currentTetris->center.x = nextTetris->center.x;
+	currentTetris->center.y = nextTetris->center.y;
+	currentTetris->color_num = nextTetris->color_num;
+	currentTetris->next_type = nextTetris->next_type;
+	currentTetris->type = nextTetris->type;
+	tetrisShape(currentTetris);
+}
+
+/*
+ * Function to generate random tetris from the bag
+ */
+void tetrisInit(tetrisBlock* blockPtr, tetrisBag *bag) {
+	blockPtr->center.x = 4;
+	blockPtr->center.y = 0;
+	blockPtr->type = bagNextType(bag);
+	blockPtr->color_num = randomBelow(&bag->random, 4) + 1; // color[0] used only for background
+	tetrisShape(blockPtr);
+}
+
+/*
+ * Function to set the square positions of a tetris from the shape table
+ */
+void tetrisShape(tetrisBlock* blockPtr){
+	const tetrisShapeInfo *shape = &tetrisShapes[blockPtr->type];
+	for (int i = 0; i < 4; i++){
+		blockPtr->position[i].x = blockPtr->center.x + shape->x[i];
+		blockPtr->position[i].y = blockPtr->center.y + shape->y[i];
+	}
+	blockPtr->next_type = shape->next;
+}
+
+/*
+ * Function to control the movement of tetris
+ */
+int tetrisMove(tetrisBlock* blockPtr, direction direct, tetrisBoard *board){
+	int x = blockPtr->center.x;
+	int y = blockPtr->center.y;
+
+	switch(direct){
+	case down:{
+		y++;
+		break;
+	}
+	case left:{
+		x--;
+		break;
+	}
+	case right:{
+		x++;
+		break;
+	}
+	}
+	if (!shapeFits(board, blockPtr->type, x, y))
+		return 0; // Keep the original position due to collision with walls, floor or fixed blocks
+	blockPtr->center.x = x;
+	blockPtr->center.y = y;
+	tetrisShape(blockPtr);
+	return 1; // Tetris can move
+}
+
+/*
+ * Function to control the rotation of tetris
+ */
+void tetrisRotate(tetrisBlock* blockPtr, tetrisBoard *board){
+	int next_type = tetrisShapes[blockPtr->type].next;
+	if (shapeFits(board, next_type, blockPtr->center.x, blockPtr->center.y)){ // Walls are sentinel cells of the board
+		blockPtr->type = next_type;
+		tetrisShape(blockPtr);
+	}
+}
+
+/*
+ * Function to let the tetris fall straight to its landing position
+ */
+void tetrisDrop(tetrisBlock* blockPtr, tetrisBoard *board){
+	blockPtr->center.y += shapeDropDistance(board, blockPtr->type, blockPtr->center.x, blockPtr->center.y);
+	tetrisShape(blockPtr);
+}
@@ -0,0 +1,141 @@
+/**
+ * Game logic of the TETRIS game without any dependency on FreeRTOS, the GPIOs
+ * or uGFX, so the same code runs on the board and on the host.
+ *
+ * The firmware feeds the secured button of every event into getState and the
+ * operations of the resulting state, and draws the game from tetrisGame.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_game_INCLUDED
+#define tetris_game_INCLUDED
+
+#include <stdint.h>
+#include "tetris_board.h"
+#include "tetris_gravity.h"
+#include "tetris_random.h"
+
+#define levelNum 4 // Levels to start a game with, the game speeds up to gravityLevels
+#define maxLineDisappear 4
+// Set longer round time for double mode than single mode due to higher difficulty
+#define singleModeSpeed 400
+#define doubleModeSpeed 600
+
+/*----------------------------------------enum, struct----------------------------------------*/
+enum currentState{ // Game state types
+	gameMenu,
+	selectMenu,
+	initGame,
+	inGame,
+	nextRound,
+	gamePause,
+	gameOver
+};
+
+enum currentMode{ // Game mode types
+	modeSelect, // Select game parameters on the main menu
+	singlePlayer,
+	doublePlayerSelect,
+	doublePlayerRotate,
+	doublePlayerMove
+};
+
+enum button{ // User input types
+	A,
+	B,
+	C,
+	D,
+	E,
+	K, // Joystick button
+	system_refresh // Condition without pressing of any button
+};
+
+enum direction{ // Tetris directions of movement
+	down,
+	left,
+	right
+};
+
+struct tetrisPoint {
+	int16_t x;
+	int16_t y;
+};
+
+struct tetrisBlock { // Tetris parameters
+	struct tetrisPoint center; // Central coordinate of the tetris for rotation
+	struct tetrisPoint position[4]; // Positions containing the coordinates of 4 squares
+	int type;
+	int next_type;
+	int color_num;
+};
+
+struct tetrisGame {
+	tetrisBoard board; // Fixed blocks
+	struct tetrisBlock current; // Falling tetris, drawn over the fixed blocks
+	struct tetrisBlock next;
+	tetrisBag bag; // Randomizer of the tetris, seeded once per game
+	uint32_t seed; // Seed of the running game, the same seed and inputs replay the same game
+	enum currentMode mode;
+	int speed; // Round time at level 0 in ms
+	tetrisGravity gravity;
+	int score, level, lines;
+	int startLevel;
+	int pieces; // Tetris fixed in the running game
+	int gravity20G; // Falling tetris lands immediately in single mode when set
+	int isGameOver;
+	// Inputs of the buddy's board, copied in by the firmware before every getState
+	int connected;
+	int buddyA, buddyC;
+};
+/*----------------------------------------END enum, struct----------------------------------------*/
+
+/*----------------------------------------typedef enum, struct----------------------------------------*/
+typedef enum currentState currentState;
+typedef enum currentMode currentMode;
+typedef enum button button;
+typedef enum direction direction;
+typedef struct tetrisPoint tetrisPoint;
+typedef struct tetrisBlock tetrisBlock;
+typedef struct tetrisGame tetrisGame;
+/*----------------------------------------END typedef enum, struct----------------------------------------*/
+
+// Manage game state
+void gameReset(tetrisGame *game);
+void gameStart(tetrisGame *game, uint32_t seed);
+currentState getState(tetrisGame *game, currentState state, button privateButton);
+
+// Game operations of the states
+void gameInput(tetrisGame *game, button privateButton);
+uint32_t gameRound(tetrisGame *game, button privateButton);
+int gameGravity(tetrisGame *game, int frames, int *rows);
+int gameShift(tetrisGame *game, button privateButton, int moves);
+uint32_t gameLockTetris(tetrisGame *game);
+void gameNextTetris(tetrisGame *game);
+void gameAddLines(tetrisGame *game, int lineNum);
+
+// Check tetris conditions to trigger next operation
+int checkNewTetris(tetrisBlock *tetrisPtr, tetrisBoard *board);
+uint32_t checkFullLine(uint32_t lockedRows, tetrisBoard *board);
+void letLineDisappear(uint32_t fullLines, tetrisBoard *board);
+int checkGameOver(tetrisBlock *blockPtr);
+
+// Modify the fixed block map
+void clearMap(tetrisBoard *board);
+void clearTetrisPosition(tetrisBlock* blockPtr, tetrisBoard *board);
+void printTetrisOnMap(tetrisBlock *blockPtr, tetrisBoard *board);
+
+// Check tetris positions relative to the fixed block map
+uint32_t getRows(tetrisBlock* blockPtr);
+
+// Generate tetris blocks
+void copyTetris(tetrisBlock *currentTetris, tetrisBlock *nextTetris);
+void tetrisInit(tetrisBlock* blockPtr, tetrisBag *bag);
+void tetrisShape(tetrisBlock* blockPtr);
+
+// Tetris operations
+int tetrisMove(tetrisBlock* blockPtr, direction direct, tetrisBoard *board);
+void tetrisRotate(tetrisBlock* blockPtr, tetrisBoard *board);
+void tetrisDrop(tetrisBlock* blockPtr, tetrisBoard *board);
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ * Gravity of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_gravity.h"
+
+/*
+ * Cells per frame of every level in single mode. Level 0 to 3 keep the round
+ * times of 400/(level+1) ms, the later levels speed up to 20 cells per frame.
+ */
+const uint32_t gravityTable[gravityLevels] = {
+	2731, 5461, 8192, 10923, // 1/24, 1/12, 1/8, 1/6
+	13653, 16384, 21845, 32768, // 1/4.8, 1/4, 1/3, 1/2
+	43691, 65536, 2 * gravityOne, 3 * gravityOne, // 2/3, 1, 2, 3
+	5 * gravityOne, 10 * gravityOne, 20 * gravityOne // 5, 10, 20
+};
+
+/*
+ * Function to start the gravity of a game without any fallen fraction
+ */
+void gravityInit(tetrisGravity *gravity, uint32_t cellsPerFrame, int lockFrames){
+	gravity->cellsPerFrame = cellsPerFrame;
+	gravity->fraction = 0;
+	gravity->lockFrames = lockFrames;
+	gravity->lockTimer = lockFrames;
+	gravity->lowestY = 0;
+	gravity->pieces = -1; // Restart the lock delay with the first tetris
+}
+
+/*
+ * Function to add the gravity of some frames, returns the whole cells to fall
+ * and keeps the fraction for the next frames
+ */
+int gravityAdvance(tetrisGravity *gravity, int frames){
+	if (frames <= 0)
+		return 0;
+	uint64_t total = gravity->fraction + (uint64_t)gravity->cellsPerFrame * (uint32_t)frames;
+	gravity->fraction = (uint32_t)(total & (gravityOne - 1));
+	return total >> 16 > 0x7FFF ? 0x7FFF : (int)(total >> 16);
+}
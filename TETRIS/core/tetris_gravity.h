@@ -0,0 +1,39 @@
+/**
+ * Gravity of the TETRIS game.
+ *
+ * Gravity is counted in frames of a hardware timer running at gravityFrameRate.
+ * Every level has a speed in cells per frame as a 16.16 fixed point number, and
+ * the fraction of a cell is carried over from frame to frame, so a speed like
+ * 1/24 cell per frame falls exactly 1 cell in 24 frames no matter how the frames
+ * are handed in. A tetris resting on the stack is fixed after a lock delay.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_gravity_INCLUDED
+#define tetris_gravity_INCLUDED
+
+#include <stdint.h>
+
+#define gravityFrameRate 60 // Frames per second of the gravity timer
+#define gravityLevels 15
+#define gravityOne 65536 // 1 cell per frame
+#define gravityLockFrames 30 // Lock delay of 500 ms
+
+struct tetrisGravity {
+	uint32_t cellsPerFrame; // 16.16 fixed point
+	uint32_t fraction; // Part of a cell fallen so far, 16.16 fixed point
+	int lockFrames; // Lock delay in frames, 0 fixes a tetris as soon as it rests on the stack
+	int lockTimer; // Frames left until the resting tetris is fixed
+	int lowestY; // Lowest row the falling tetris reached, the lock delay restarts below it
+	int pieces; // Fixed tetris count of the game when the falling tetris appeared
+};
+
+typedef struct tetrisGravity tetrisGravity;
+
+extern const uint32_t gravityTable[gravityLevels];
+
+void gravityInit(tetrisGravity *gravity, uint32_t cellsPerFrame, int lockFrames);
+int gravityAdvance(tetrisGravity *gravity, int frames);
+
+#endif
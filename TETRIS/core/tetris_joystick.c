@@ -0,0 +1,97 @@
+/**
+ * Analog joystick of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_joystick.h"
+#include "tetris_gravity.h"
+
+/*
+ * Function to reset an axis, its next blocks of samples give the rest position
+ */
+void joystickAxisInit(tetrisJoystick *axis){
+	axis->center = 0;
+	axis->calibration = 0;
+	axis->filtered = 0;
+	axis->deflection = 0;
+	axis->direction = 0;
+	axis->fraction = 0;
+}
+
+/*
+ * Function to filter a block of samples into the deflection of the axis, returns the deflection
+ */
+int joystickFilter(tetrisJoystick *axis, const uint16_t *samples, int count){
+	int32_t sum = 0, low[2] = {joystickSampleMask, joystickSampleMask}, high[2] = {0, 0};
+	if (count <= 0)
+		return axis->deflection;
+	for (int n = 0; n < count; n++){
+		int32_t sample = samples[n] & joystickSampleMask;
+		sum += sample;
+		if (sample < low[1]){ // 2 lowest samples, low[0] <= low[1]
+			low[1] = sample < low[0] ? low[0] : sample;
+			low[0] = sample < low[0] ? sample : low[0];
+		}
+		if (sample > high[1]){ // 2 highest samples, high[0] >= high[1]
+			high[1] = sample > high[0] ? high[0] : sample;
+			high[0] = sample > high[0] ? sample : high[0];
+		}
+	}
+	if (count > 4){ // Drop the spikes
+		sum -= low[0] + low[1] + high[0] + high[1];
+		count -= 4;
+	}
+	int32_t mean = (sum << joystickFilterBits) / count;
+	if (axis->calibration < joystickCalibrationBlocks){ // Average of the blocks so far
+		axis->calibration++;
+		axis->center += (mean - axis->center) / axis->calibration;
+		axis->filtered = axis->center;
+	}
+	else
+		axis->filtered += (mean - axis->filtered) / (1 << joystickSmoothShift);
+
+	int32_t deflection = (axis->filtered - axis->center) / (1 << joystickFilterBits);
+	if (deflection > joystickFull)
+		deflection = joystickFull;
+	else if (deflection < -joystickFull)
+		deflection = -joystickFull;
+	axis->deflection = deflection;
+	return deflection;
+}
+
+/*
+ * Function to get the repeat rate of a deflection in moves per frame, 16.16 fixed point
+ */
+uint32_t joystickRate(int deflection){
+	int magnitude = deflection < 0 ? -deflection : deflection;
+	if (magnitude <= joystickDeadZone)
+		return 0;
+	if (magnitude > joystickFull)
+		magnitude = joystickFull;
+	uint64_t rate = (uint64_t)joystickMinRate * (joystickFull - magnitude) + (uint64_t)joystickMaxRate * (magnitude - joystickDeadZone);
+	return (uint32_t)(rate * gravityOne / ((uint64_t)gravityFrameRate * (joystickFull - joystickDeadZone)));
+}
+
+/*
+ * Function to add frames to the axis, returns the moves to apply for these frames,
+ * negative in the negative direction of the axis
+ */
+int joystickMoves(tetrisJoystick *axis, int frames){
+	int32_t deflection = axis->deflection;
+	int direction = deflection > 0 ? 1 : -1;
+	int magnitude = deflection < 0 ? -deflection : deflection;
+	if (axis->direction && (direction != axis->direction || magnitude < joystickDeadZone - joystickHysteresis))
+		axis->direction = 0; // Back to rest
+	if (!axis->direction){
+		if (magnitude <= joystickDeadZone)
+			return 0;
+		axis->direction = direction;
+		axis->fraction = 0;
+		return direction; // Leaving the dead zone moves once like a press
+	}
+	axis->fraction += joystickRate(magnitude) * (uint32_t)(frames > 0 ? frames : 0);
+	int moves = (int)(axis->fraction >> 16);
+	axis->fraction &= gravityOne - 1;
+	return moves * direction;
+}
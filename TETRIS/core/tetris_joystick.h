@@ -0,0 +1,47 @@
+/**
+ * Analog joystick of the TETRIS game.
+ *
+ * The samples of an axis arrive in blocks from a circular DMA buffer. Every
+ * block is reduced to the mean of its samples without the 2 lowest and the 2
+ * highest ones, which removes spikes, and smoothed from block to block.
+ * The mean of the first blocks is the rest position of the axis. Out of the dead
+ * zone the axis moves the falling tetris once, then repeats at a rate growing
+ * linearly with the deflection, carried over in 16.16 fixed point like the
+ * gravity. A hysteresis keeps an axis at the edge of the dead zone from
+ * chattering.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_joystick_INCLUDED
+#define tetris_joystick_INCLUDED
+
+#include <stdint.h>
+
+#define joystickSampleMask 0x0FFF // 12 bit samples
+#define joystickFull 2048 // Largest deflection from the rest position
+#define joystickDeadZone 500
+#define joystickHysteresis 150 // An axis comes back to rest below joystickDeadZone - joystickHysteresis
+#define joystickSmoothShift 1 // Every block moves the filter half way to its mean
+#define joystickFilterBits 4 // Fraction bits of the filter
+#define joystickCalibrationBlocks 16 // Blocks averaged into the rest position
+#define joystickMinRate 5 // Moves per second right out of the dead zone
+#define joystickMaxRate 40 // Moves per second at full deflection
+
+struct tetrisJoystick {
+	int32_t center; // Rest position in filter units
+	int calibration; // Blocks averaged into the rest position so far
+	int32_t filtered; // Smoothed position in filter units
+	volatile int32_t deflection; // From -joystickFull to joystickFull, written by the DMA interrupt
+	int direction; // 1 or -1 out of the dead zone, 0 at rest
+	uint32_t fraction; // Part of a move repeated so far, 16.16 fixed point
+};
+
+typedef struct tetrisJoystick tetrisJoystick;
+
+void joystickAxisInit(tetrisJoystick *axis);
+int joystickFilter(tetrisJoystick *axis, const uint16_t *samples, int count);
+uint32_t joystickRate(int deflection);
+int joystickMoves(tetrisJoystick *axis, int frames);
+
+#endif
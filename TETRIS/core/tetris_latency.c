@@ -0,0 +1,89 @@
+/**
+ * Latency histograms of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_latency.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Get the bucket of a value
+ */
+static int latencyBucket(uint32_t value){
+	if (value < (2u << latencySubBits))
+		return (int)value;
+	int exponent = 31 - __builtin_clz(value);
+	int shift = exponent - latencySubBits;
+	return ((shift + 1) << latencySubBits) + (int)(value >> shift) - (1 << latencySubBits);
+}
+
+/*
+ * Get the largest value of a bucket
+ */
+static uint32_t latencyBucketTop(int bucket){
+	if (bucket < (2 << latencySubBits))
+		return (uint32_t)bucket;
+	int shift = (bucket >> latencySubBits) - 1;
+	uint64_t mantissa = (uint64_t)(bucket & ((1 << latencySubBits) - 1)) + (1 << latencySubBits);
+	return (uint32_t)(((mantissa + 1) << shift) - 1);
+}
+
+/*
+ * Function to empty a histogram
+ */
+void latencyInit(tetrisLatency *latency){
+	memset(latency, 0, sizeof(*latency));
+	latency->min = UINT32_MAX;
+}
+
+/*
+ * Function to add a sample to a histogram
+ */
+void latencyAdd(tetrisLatency *latency, uint32_t value){
+	latency->count++;
+	latency->sum += value;
+	if (value < latency->min)
+		latency->min = value;
+	if (value > latency->max)
+		latency->max = value;
+	latency->buckets[latencyBucket(value)]++;
+}
+
+uint32_t latencyAverage(const tetrisLatency *latency){
+	return latency->count ? (uint32_t)(latency->sum / latency->count) : 0;
+}
+
+/*
+ * Function to get the value below which permille of the samples are, rounded up
+ * to the top of its bucket but never above the maximum
+ */
+uint32_t latencyPercentile(const tetrisLatency *latency, int permille){
+	if (!latency->count)
+		return 0;
+	uint64_t rank = ((uint64_t)latency->count * permille + 999) / 1000; // Samples at or below the percentile
+	uint64_t seen = 0;
+	if (rank < 1)
+		rank = 1;
+	for (int bucket = 0; bucket < latencyBuckets; bucket++){
+		seen += latency->buckets[bucket];
+		if (seen >= rank){
+			uint32_t top = latencyBucketTop(bucket);
+			return top < latency->max ? top : latency->max;
+		}
+	}
+	return latency->max;
+}
+
+/*
+ * Function to print a line of the count, minimum, average, 99th percentile and
+ * maximum of a histogram in units of unit counts, returns the length of the line
+ */
+int latencyFormat(const tetrisLatency *latency, const char *name, uint32_t unit, char *text, int size){
+	if (!unit)
+		unit = 1;
+	return snprintf(text, (size_t)size, "%-6s %6lu %6lu %6lu %6lu %6lu", name, (unsigned long)latency->count,
+			(unsigned long)(latency->count ? latency->min / unit : 0), (unsigned long)(latencyAverage(latency) / unit),
+			(unsigned long)(latencyPercentile(latency, 990) / unit), (unsigned long)(latency->max / unit));
+}
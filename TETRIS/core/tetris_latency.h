@@ -0,0 +1,36 @@
+/**
+ * Latency histograms of the TETRIS game.
+ *
+ * A histogram keeps the count, minimum, maximum and sum of its samples and
+ * sorts them into log-linear buckets: the values below 16 have a bucket each,
+ * every power of 2 above is split into 8 buckets, so a percentile is found
+ * within 1/8 of its value by walking 240 counters, whatever the range of the
+ * samples. Adding a sample takes no division and no allocation.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_latency_INCLUDED
+#define tetris_latency_INCLUDED
+
+#include <stdint.h>
+
+#define latencySubBits 3 // 8 buckets per power of 2
+#define latencyBuckets ((33 - latencySubBits) << latencySubBits)
+
+struct tetrisLatency {
+	uint32_t count;
+	uint32_t min, max;
+	uint64_t sum;
+	uint32_t buckets[latencyBuckets];
+};
+
+typedef struct tetrisLatency tetrisLatency;
+
+void latencyInit(tetrisLatency *latency);
+void latencyAdd(tetrisLatency *latency, uint32_t value);
+uint32_t latencyAverage(const tetrisLatency *latency);
+uint32_t latencyPercentile(const tetrisLatency *latency, int permille);
+int latencyFormat(const tetrisLatency *latency, const char *name, uint32_t unit, char *text, int size);
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * Placement enumeration ("perft") of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_perft.h"
+#include "tetris_shape.h"
+#include "tetris_game.h"
+
+#define perftColumns 16 // Center columns -2 to 13 of the padded row masks
+#define perftMaxStates (4 * boardHeight * perftColumns)
+
+/*
+ * Get a key of the squares covered by a fixed tetris, equal for all types and
+ * centers that cover the same squares: the top row and the masks of the rows below it
+ */
+static uint64_t placementKey(int type, int x, int y){
+	const tetrisShapeInfo *shape = &tetrisShapes[type];
+	int shift = x + shape->left;
+	int top = 0;
+	while (!shape->mask[top])
+		top++;
+	uint64_t key = (uint64_t)(y + shapeTopOffset + top) << 40;
+	for (int i = top; i < 4; i++)
+		key |= (uint64_t)((uint32_t)shape->mask[i] << shift) << (10 * (i - top));
+	return key;
+}
+
+/*
+ * Function to find every distinct position where a tetris spawned on the board
+ * can be fixed, searching all positions reachable by rotating, shifting and
+ * moving down. Returns the number of placements, 0 when the tetris has no room to spawn.
+ */
+int perftPlacements(const tetrisBoard *board, int type, tetrisPlacement placements[perftMaxPlacements]){
+	uint8_t types[4]; // Types reached by rotating from the spawned type
+	int rotations = 0;
+	int t = type;
+	do {
+		types[rotations++] = (uint8_t)t;
+		t = tetrisShapes[t].next;
+	} while (t != type && rotations < 4);
+
+	uint16_t visited[4][boardHeight] = {{0}}; // Bit x+2 of a visited center per rotation and row
+	struct { int8_t x, y, rot; } queue[perftMaxStates];
+	uint64_t keys[perftMaxPlacements];
+	int head = 0, tail = 0, count = 0;
+
+	if (!shapeFits(board, type, perftSpawnX, perftSpawnY))
+		return 0;
+	visited[0][perftSpawnY] |= 1u << (perftSpawnX + 2);
+	queue[tail].x = perftSpawnX;
+	queue[tail].y = perftSpawnY;
+	queue[tail++].rot = 0;
+
+	while (head < tail){
+		int x = queue[head].x, y = queue[head].y, rot = queue[head].rot;
+		head++;
+		int next[4][3] = {{x, y + 1, rot}, {x - 1, y, rot}, {x + 1, y, rot}, {x, y, (rot + 1) % rotations}};
+		for (int i = 0; i < 4; i++){
+			int nx = next[i][0], ny = next[i][1], nrot = next[i][2];
+			if (!shapeFits(board, types[nrot], nx, ny)){
+				if (i == 0){ // Cannot move down, the tetris is fixed here
+					uint64_t key = placementKey(types[rot], x, y);
+					int known = 0;
+					for (int k = 0; k < count && !known; k++)
+						known = keys[k] == key;
+					if (!known){
+						keys[count] = key;
+						placements[count].x = (int8_t)x;
+						placements[count].y = (int8_t)y;
+						placements[count++].type = types[rot];
+					}
+				}
+				continue;
+			}
+			if (visited[nrot][ny] & (1u << (nx + 2)))
+				continue;
+			visited[nrot][ny] |= 1u << (nx + 2);
+			queue[tail].x = (int8_t)nx;
+			queue[tail].y = (int8_t)ny;
+			queue[tail++].rot = (int8_t)nrot;
+		}
+	}
+	return count;
+}
+
+/*
+ * Function to fix a tetris on the board and eliminate full lines the same way as the game.
+ * Returns whether the game is over.
+ */
+int perftPlace(tetrisBoard *board, const tetrisPlacement *placement){
+	tetrisBlock block;
+	block.center.x = placement->x;
+	block.center.y = placement->y;
+	block.type = placement->type;
+	block.color_num = 1;
+	tetrisShape(&block);
+	printTetrisOnMap(&block, board);
+	uint32_t fullLines = checkFullLine(getRows(&block), board);
+	letLineDisappear(fullLines, board);
+	return checkGameOver(&block);
+}
+
+/*
+ * Function to count the placements of a sequence of depth tetris, every one
+ * fixed on the board left by the previous one. A placement that ends the game
+ * only counts when it is the last one of the sequence.
+ */
+uint64_t perftCount(const tetrisBoard *board, const uint8_t *types, int depth){
+	tetrisPlacement placements[perftMaxPlacements];
+	if (depth <= 0)
+		return 1;
+	int count = perftPlacements(board, types[0], placements);
+	if (depth == 1)
+		return (uint64_t)count;
+	uint64_t nodes = 0;
+	for (int i = 0; i < count; i++){
+		tetrisBoard child = *board;
+		if (!perftPlace(&child, &placements[i]))
+			nodes += perftCount(&child, types + 1, depth - 1);
+	}
+	return nodes;
+}
@@ -0,0 +1,36 @@
+/**
+ * Placement enumeration ("perft") of the TETRIS game.
+ *
+ * Generates every distinct position where a tetris can be fixed on a board,
+ * reachable from the spawn position by the same operations as the player:
+ * rotation (A), shifts (B, D) and moving down (C). Counting the placements of
+ * a sequence of tetris recursively gives a number that only depends on the
+ * move rules, so it checks the collision and line clearing code against known
+ * values and measures how fast the engine generates positions.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_perft_INCLUDED
+#define tetris_perft_INCLUDED
+
+#include <stdint.h>
+#include "tetris_board.h"
+
+#define perftMaxPlacements (4 * boardWidth * boardHeight) // Orientations x columns x rows bound the distinct fixed positions
+#define perftSpawnX 4
+#define perftSpawnY 0
+
+struct tetrisPlacement {
+	int8_t x; // Center of the fixed tetris
+	int8_t y;
+	uint8_t type;
+};
+
+typedef struct tetrisPlacement tetrisPlacement;
+
+int perftPlacements(const tetrisBoard *board, int type, tetrisPlacement placements[perftMaxPlacements]);
+int perftPlace(tetrisBoard *board, const tetrisPlacement *placement);
+uint64_t perftCount(const tetrisBoard *board, const uint8_t *types, int depth);
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ * Random numbers of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_random.h"
+
+#define pcgMultiplier 6364136223846793005ull
+#define pcgIncrement 1442695040888963407ull
+
+// The 4 types of every shape: Z, S, J, L, T, O, I
+static const uint8_t shapeTypes[bagSize][4] = {
+	{0, 1, 19, 20},
+	{2, 3, 21, 22},
+	{4, 5, 6, 7},
+	{8, 9, 10, 11},
+	{12, 13, 14, 15},
+	{16, 23, 24, 25},
+	{17, 18, 26, 27}
+};
+
+/*
+ * Function to start the generator from a seed, the same seed always gives the same numbers
+ */
+void randomSeed(tetrisRandom *random, uint32_t seed){
+	random->state = 0;
+	randomNext(random);
+	random->state += seed;
+	randomNext(random);
+}
+
+/*
+ * Function to get the next 32 bit random number
+ */
+uint32_t randomNext(tetrisRandom *random){
+	uint64_t state = random->state;
+	random->state = state * pcgMultiplier + pcgIncrement;
+	uint32_t xorshifted = (uint32_t)(((state >> 18) ^ state) >> 27);
+	uint32_t rot = (uint32_t)(state >> 59);
+	return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+/*
+ * Function to get a random number from 0 to bound - 1 without the bias of a modulo
+ */
+uint32_t randomBelow(tetrisRandom *random, uint32_t bound){
+	uint64_t product = (uint64_t)randomNext(random) * bound;
+	if ((uint32_t)product < bound){
+		uint32_t threshold = (0u - bound) % bound;
+		while ((uint32_t)product < threshold)
+			product = (uint64_t)randomNext(random) * bound;
+	}
+	return (uint32_t)(product >> 32);
+}
+
+/*
+ * Function to start a new sequence of bags from a seed
+ */
+void bagSeed(tetrisBag *bag, uint32_t seed){
+	randomSeed(&bag->random, seed);
+	bag->next = bagSize;
+}
+
+/*
+ * Function to get the type of the next tetris, refilling and shuffling the bag when it is empty
+ */
+int bagNextType(tetrisBag *bag){
+	if (bag->next >= bagSize){
+		for (int i = 0; i < bagSize; i++)
+			bag->shapes[i] = (uint8_t)i;
+		for (int i = bagSize - 1; i > 0; i--){ // Fisher-Yates shuffle
+			int j = (int)randomBelow(&bag->random, (uint32_t)i + 1);
+			uint8_t shape = bag->shapes[i];
+			bag->shapes[i] = bag->shapes[j];
+			bag->shapes[j] = shape;
+		}
+		bag->next = 0;
+	}
+	return shapeTypes[bag->shapes[bag->next++]][randomBelow(&bag->random, 4)];
+}
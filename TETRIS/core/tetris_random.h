@@ -0,0 +1,40 @@
+/**
+ * Random numbers of the TETRIS game.
+ *
+ * A PCG32 generator with its whole state in a struct, so a game can be
+ * replayed from its 32 bit seed and drawing a number needs neither the libc
+ * rand() nor its reentrancy data. On top of it a 7-bag randomizer deals the
+ * seven shapes in shuffled bags, every shape exactly once per 7 tetris, with
+ * a random rotation among the 4 types of the shape.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_random_INCLUDED
+#define tetris_random_INCLUDED
+
+#include <stdint.h>
+
+#define bagSize 7 // Number of shapes
+
+struct tetrisRandom {
+	uint64_t state;
+};
+
+struct tetrisBag {
+	struct tetrisRandom random;
+	uint8_t shapes[bagSize]; // Shuffled shapes of the current bag
+	uint8_t next; // Position of the next shape in the bag, bagSize for an empty bag
+};
+
+typedef struct tetrisRandom tetrisRandom;
+typedef struct tetrisBag tetrisBag;
+
+void randomSeed(tetrisRandom *random, uint32_t seed);
+uint32_t randomNext(tetrisRandom *random);
+uint32_t randomBelow(tetrisRandom *random, uint32_t bound);
+
+void bagSeed(tetrisBag *bag, uint32_t seed);
+int bagNextType(tetrisBag *bag);
+
+#endif
@@ -0,0 +1,237 @@
+/**
+ * Renderer of the game scene of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_render.h"
+#include "tetris_shape.h"
+#include <stdio.h>
+#include <string.h>
+
+#define renderFieldX 110 // Playfield
+#define renderFieldY 10
+#define renderCellPitch 11
+#define renderPanelX 230 // Side panels
+#define renderPanelWidth 80
+#define renderTextX 245
+#define renderNextX 225 // Next tetris, squares overlap by a pixel
+#define renderNextY 190
+#define renderNextSize 11
+#define renderNextPitch 10
+
+struct renderBand { // Side panel with the background around it down to the next one, which its text may reach into
+	int16_t y, height;
+	int16_t panelHeight;
+	int16_t labelY, valueY;
+	const char *label;
+};
+
+static const struct renderBand renderBands[renderFields] = {
+	{10, 45, 35, 15, 30, "SCORE"},
+	{55, 45, 35, 60, 75, "LEVEL"},
+	{100, 45, 35, 105, 120, "LINE"},
+	{145, renderHeight - 145, 85, 150, 0, "NEXT"}
+};
+
+static const char *renderOperations[] = { // Instructions for game operations
+	"Operations:",
+	"A  Rotate",
+	"B  Move right",
+	"C  Move down",
+	"D  Move left",
+	"E  Pause",
+	"F  Menu",
+	"K  Drop" // Single mode only
+};
+
+static void renderDrawFill(renderTarget *target, int x, int y, int cx, int cy, int color){
+	target->fill(target->context, x, y, cx, cy, color);
+	target->calls++;
+}
+
+static void renderDrawBox(renderTarget *target, int x, int y, int cx, int cy, int color){
+	target->box(target->context, x, y, cx, cy, color);
+	target->calls++;
+}
+
+static void renderDrawText(renderTarget *target, int x, int y, const char *text, int color){
+	target->text(target->context, x, y, text, color);
+	target->calls++;
+}
+
+static void renderDrawTile(renderTarget *target, int x, int y, int look){
+	target->tile(target->context, x, y, look);
+	target->calls++;
+}
+
+/*
+ * Function to draw a cell of the playfield
+ */
+static void renderDrawCell(renderTarget *target, int col, int row, int look){
+	int x = renderFieldX + renderCellPitch * col;
+	int y = renderFieldY + renderCellPitch * row;
+	if (target->tile)
+		renderDrawTile(target, x, y, look);
+	else if (look & renderOutline){ // Outline on an empty cell
+		renderDrawFill(target, x, y, renderCellSize, renderCellSize, renderCellColor);
+		renderDrawBox(target, x, y, renderCellSize, renderCellSize, renderCellColor + (look & ~renderOutline));
+	}
+	else
+		renderDrawFill(target, x, y, renderCellSize, renderCellSize, renderCellColor + look);
+}
+
+static void renderDrawCopy(renderTarget *target, int x, int y, int cx, int cy){
+	target->copy(target->context, x, y, cx, cy);
+	target->calls++;
+}
+
+/*
+ * Function to draw the static layer of the scene of a mode
+ */
+static void renderDrawHud(renderTarget *target, currentMode mode){
+	renderDrawFill(target, 0, 0, renderWidth, renderHeight, renderBackground);
+	for (int field = 0; field < renderFields; field++){
+		const struct renderBand *band = &renderBands[field];
+		renderDrawFill(target, renderPanelX, band->y, renderPanelWidth, band->panelHeight, renderPanel);
+		renderDrawText(target, renderTextX, band->labelY, band->label, renderText);
+	}
+
+	renderDrawFill(target, 10, 10, 90, 220, renderPanel);
+	int operations = mode == singlePlayer ? 8 : 7;
+	for (int i = 0; i < operations; i++)
+		renderDrawText(target, 15, 20 + 20 * i, renderOperations[i], renderText);
+
+	// Print instruction for double mode
+	if (mode == doublePlayerMove)
+		renderDrawText(target, 25, 190, "You Move", renderModeText);
+	else if (mode == doublePlayerRotate)
+		renderDrawText(target, 25, 190, "You Rotate", renderModeText);
+
+	for (int row = 0; row < boardHeight; row++)
+		for (int col = 0; col < boardWidth; col++)
+			renderDrawCell(target, col, row, 0);
+}
+
+/*
+ * Function to draw the numbers or the next tetris of a side panel
+ */
+static void renderDrawValue(renderTarget *target, const renderFrame *frame, int field){
+	const struct renderBand *band = &renderBands[field];
+	if (field == renderNext){
+		const tetrisBlock *next = &frame->next;
+		for (int i = 0; i < 4; i++){
+			int x = renderNextX + renderNextPitch * next->position[i].x, y = renderNextY + renderNextPitch * next->position[i].y;
+			if (target->tile) // Tiles side by side, the pitch of the squares
+				renderDrawTile(target, x, y, next->color_num);
+			else
+				renderDrawFill(target, x, y, renderNextSize, renderNextSize, renderCellColor + next->color_num);
+		}
+	}
+	else {
+		char str[12];
+		snprintf(str, sizeof(str), "%5d", frame->values[field]);
+		renderDrawText(target, renderTextX, band->valueY, str, renderText);
+	}
+}
+
+/*
+ * Function to draw a side panel again, over its band restored to the static layer
+ */
+static void renderDrawPanel(renderTarget *target, const renderFrame *frame, int field){
+	const struct renderBand *band = &renderBands[field];
+	if (target->copy)
+		renderDrawCopy(target, renderPanelX, band->y, renderWidth - renderPanelX, band->height);
+	else {
+		renderDrawFill(target, renderPanelX, band->y, renderWidth - renderPanelX, band->height, renderBackground);
+		renderDrawFill(target, renderPanelX, band->y, renderPanelWidth, band->panelHeight, renderPanel);
+		renderDrawText(target, renderTextX, band->labelY, band->label, renderText);
+	}
+	renderDrawValue(target, frame, field);
+}
+
+/*
+ * Function to draw the whole scene, over a copy of the static layer if the target keeps one
+ */
+static void renderDrawScene(renderTarget *target, const renderFrame *frame){
+	if (target->copy)
+		renderDrawCopy(target, 0, 0, renderWidth, renderHeight);
+	else
+		renderDrawHud(target, frame->mode);
+	for (int field = 0; field < renderFields; field++)
+		renderDrawValue(target, frame, field);
+	for (int row = 0; row < boardHeight; row++)
+		for (int col = 0; col < boardWidth; col++)
+			if (frame->cells[row][col])
+				renderDrawCell(target, col, row, frame->cells[row][col]);
+}
+
+/*
+ * Function to draw the static layer of the game scene of a mode, for a target
+ * to keep and copy from
+ */
+void renderHud(renderTarget *target, currentMode mode){
+	target->calls = 0;
+	renderDrawHud(target, mode);
+}
+
+/*
+ * Function to compose what a frame of the game scene shows
+ */
+void renderCompose(renderFrame *frame, const tetrisSnapshot *snapshot){
+	const tetrisBlock *current = &snapshot->current;
+	frame->mode = snapshot->mode;
+	for (int row = 0; row < boardHeight; row++)
+		for (int col = 0; col < boardWidth; col++)
+			frame->cells[row][col] = boardGetColor(&snapshot->board, col, row);
+
+	// The landing position of the falling tetris as an outline, the falling tetris over it,
+	// squares in the spawn area above the map are hidden
+	int dropDistance = shapeDropDistance(&snapshot->board, current->type, current->center.x, current->center.y);
+	for (int i = 0; i < 4; i++){
+		int ghostY = current->position[i].y + dropDistance;
+		if (ghostY >= 0 && ghostY < boardHeight && (unsigned)current->position[i].x < boardWidth)
+			frame->cells[ghostY][current->position[i].x] = (uint8_t)(renderOutline | current->color_num);
+	}
+	for (int i = 0; i < 4; i++){
+		int y = current->position[i].y;
+		if (y >= 0 && y < boardHeight && (unsigned)current->position[i].x < boardWidth)
+			frame->cells[y][current->position[i].x] = (uint8_t)current->color_num;
+	}
+
+	frame->values[renderScore] = snapshot->score;
+	frame->values[renderLevel] = snapshot->level;
+	frame->values[renderLines] = snapshot->lines;
+	frame->values[renderNext] = snapshot->next.type * renderCellColors + snapshot->next.color_num;
+	frame->next = snapshot->next;
+}
+
+/*
+ * Function to draw a snapshot of the game scene, only what differs from the
+ * shadow of the frame buffer when it is valid. The shadow is updated, NULL
+ * always draws the whole scene.
+ */
+void renderGame(renderTarget *target, renderShadow *shadow, const tetrisSnapshot *snapshot){
+	renderFrame frame;
+	renderCompose(&frame, snapshot);
+	target->calls = 0;
+	if (!shadow || !shadow->valid || shadow->frame.mode != frame.mode)
+		renderDrawScene(target, &frame);
+	else {
+		const renderFrame *last = &shadow->frame;
+		for (int field = 0; field < renderFields; field++)
+			if (frame.values[field] != last->values[field])
+				renderDrawPanel(target, &frame, field);
+		for (int row = 0; row < boardHeight; row++){
+			if (!memcmp(frame.cells[row], last->cells[row], boardWidth))
+				continue;
+			for (int col = 0; col < boardWidth; col++)
+				if (frame.cells[row][col] != last->cells[row][col])
+					renderDrawCell(target, col, row, frame.cells[row][col]);
+		}
+	}
+	if (shadow){
+		shadow->frame = frame;
+		shadow->valid = 1;
+	}
+}
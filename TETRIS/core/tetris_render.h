@@ -0,0 +1,85 @@
+/**
+ * Renderer of the game scene of the TETRIS game.
+ *
+ * The scene is drawn through a renderTarget, gdisp on the board and a frame
+ * buffer in memory on the host, by fills, boxes and strings of logical colors.
+ * A frame is first composed into what it shows: the look of every cell of the
+ * playfield with the falling tetris and its landing position, the numbers of
+ * the side panels and the next tetris. A renderShadow keeps the frame last
+ * drawn into a frame buffer, and only the cells and panels which differ from
+ * it are drawn again. Without a valid shadow the whole scene is drawn.
+ *
+ * The background, the panels with their labels, the instructions with the
+ * mode line and the empty playfield never change during a game. A target with
+ * a copy function keeps them drawn by renderHud in a layer of its own, and the
+ * whole scene starts with a copy of that layer instead of drawing them again.
+ * A target with a tile function draws every cell, those of the next tetris
+ * included, as a tile of renderCellSize pixels in one call.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_render_INCLUDED
+#define tetris_render_INCLUDED
+
+#include <stdint.h>
+#include "tetris_board.h"
+#include "tetris_game.h"
+#include "tetris_snapshot.h"
+
+#define renderWidth 320
+#define renderHeight 240
+#define renderCellColors 5 // Color 0 is the empty cell, 1 to 4 the tetris
+#define renderOutline 0x08 // Look of a cell drawn as the outline of its color, the landing position
+#define renderCellSize 10
+
+enum renderColor { // Logical colors, mapped to pixels by the target
+	renderBackground,
+	renderPanel,
+	renderText,
+	renderModeText,
+	renderCellColor, // Cell color n is renderCellColor + n
+	renderColors = renderCellColor + renderCellColors
+};
+
+enum renderField { // Side panels redrawn as a whole when their content changes
+	renderScore,
+	renderLevel,
+	renderLines,
+	renderNext,
+	renderFields
+};
+
+struct renderTarget {
+	void *context;
+	void (*fill)(void *context, int x, int y, int cx, int cy, int color);
+	void (*box)(void *context, int x, int y, int cx, int cy, int color);
+	void (*text)(void *context, int x, int y, const char *text, int color);
+	void (*copy)(void *context, int x, int y, int cx, int cy); // Copy from the static layer, NULL to draw it instead
+	void (*tile)(void *context, int x, int y, int look); // Cell of a look at (x, y), NULL to draw it by fills
+	uint32_t calls; // Fills, boxes and strings of the last frame
+};
+
+struct renderFrame { // What the game scene shows
+	currentMode mode;
+	uint8_t cells[boardHeight][boardWidth]; // Color number of every cell, renderOutline for the landing position
+	int values[renderFields]; // Score, level and lines, type and color of the next tetris
+	tetrisBlock next;
+};
+
+struct renderShadow { // Frame last drawn into a frame buffer
+	int valid;
+	struct renderFrame frame;
+};
+
+typedef enum renderColor renderColor;
+typedef enum renderField renderField;
+typedef struct renderTarget renderTarget;
+typedef struct renderFrame renderFrame;
+typedef struct renderShadow renderShadow;
+
+void renderCompose(renderFrame *frame, const tetrisSnapshot *snapshot);
+void renderHud(renderTarget *target, currentMode mode);
+void renderGame(renderTarget *target, renderShadow *shadow, const tetrisSnapshot *snapshot);
+
+#endif
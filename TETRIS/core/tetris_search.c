@@ -0,0 +1,255 @@
+/**
+ * Multithreaded placement search of the TETRIS game, host only.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_search.h"
+#include "tetris_perft.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+/*
+ * Entry of the transposition table. The check word holds key ^ nodes, so an
+ * entry torn by two threads storing at the same time no longer matches its key
+ * and reads as a miss, without any lock.
+ */
+struct searchEntry {
+	_Atomic uint64_t check;
+	_Atomic uint64_t nodes;
+};
+
+struct searchTask {
+	tetrisBoard board;
+	int index; // Position of the next tetris in the sequence
+	int depth; // Remaining tetris to place
+};
+
+struct searchDeque { // The owner takes tasks from the tail, thieves from the head
+	pthread_mutex_t lock;
+	struct searchTask *tasks;
+	int head, tail;
+};
+
+struct searchContext {
+	const uint8_t *types;
+	struct searchEntry *table;
+	uint64_t tableMask;
+	struct searchDeque *deques;
+	int threads;
+	_Atomic uint64_t nodes;
+	_Atomic uint64_t steals;
+	_Atomic uint64_t tableProbes;
+	_Atomic uint64_t tableHits;
+};
+
+struct searchWorker {
+	struct searchContext *ctx;
+	int id;
+	uint64_t tableProbes, tableHits; // Local counters, added to the context once at the end
+};
+
+/*
+ * Get a 64 bit hash of the fixed blocks of the board
+ */
+uint64_t searchBoardHash(const tetrisBoard *board){
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (int row = 0; row < boardHeight; row++)
+		hash = (hash ^ boardRow(board, row)) * 0x100000001B3ull;
+	hash ^= hash >> 29;
+	hash *= 0xBF58476D1CE4E5B9ull;
+	return hash ^ (hash >> 32);
+}
+
+static uint64_t searchKey(const tetrisBoard *board, int index, int depth){
+	uint64_t key = searchBoardHash(board) ^ ((uint64_t)index << 56) ^ ((uint64_t)depth << 48);
+	return key | 1; // An empty entry never matches
+}
+
+/*
+ * Count the placements below a board, looking up and storing subtrees of at least 2 tetris
+ */
+static uint64_t searchNode(struct searchWorker *worker, const tetrisBoard *board, int index, int depth){
+	struct searchContext *ctx = worker->ctx;
+	tetrisPlacement placements[perftMaxPlacements];
+	struct searchEntry *entry = NULL;
+	uint64_t key = 0;
+
+	if (depth <= 0)
+		return 1;
+	if (depth >= 2 && ctx->table){
+		key = searchKey(board, index, depth);
+		entry = &ctx->table[key & ctx->tableMask];
+		uint64_t nodes = atomic_load_explicit(&entry->nodes, memory_order_relaxed);
+		uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+		worker->tableProbes++;
+		if ((check ^ nodes) == key){
+			worker->tableHits++;
+			return nodes;
+		}
+	}
+
+	int count = perftPlacements(board, ctx->types[index], placements);
+	if (depth == 1)
+		return (uint64_t)count;
+	uint64_t nodes = 0;
+	for (int i = 0; i < count; i++){
+		tetrisBoard child = *board;
+		if (!perftPlace(&child, &placements[i]))
+			nodes += searchNode(worker, &child, index + 1, depth - 1);
+	}
+
+	if (entry){
+		atomic_store_explicit(&entry->nodes, nodes, memory_order_relaxed);
+		atomic_store_explicit(&entry->check, key ^ nodes, memory_order_relaxed);
+	}
+	return nodes;
+}
+
+/*
+ * Take a task from the own deque, or steal one from the other threads
+ */
+static int searchTake(struct searchWorker *worker, struct searchTask *task){
+	struct searchContext *ctx = worker->ctx;
+	for (int n = 0; n < ctx->threads; n++){
+		struct searchDeque *deque = &ctx->deques[(worker->id + n) % ctx->threads];
+		int found = 0;
+		pthread_mutex_lock(&deque->lock);
+		if (deque->head < deque->tail){
+			*task = n == 0 ? deque->tasks[--deque->tail] : deque->tasks[deque->head++];
+			found = 1;
+		}
+		pthread_mutex_unlock(&deque->lock);
+		if (found){
+			if (n)
+				atomic_fetch_add(&ctx->steals, 1);
+			return 1;
+		}
+	}
+	return 0; // All tasks are taken, no new tasks appear during the search
+}
+
+static void *searchThread(void *arg){
+	struct searchWorker *worker = arg;
+	struct searchContext *ctx = worker->ctx;
+	struct searchTask task;
+	uint64_t nodes = 0;
+	while (searchTake(worker, &task))
+		nodes += searchNode(worker, &task.board, task.index, task.depth);
+	atomic_fetch_add(&ctx->nodes, nodes);
+	atomic_fetch_add(&ctx->tableProbes, worker->tableProbes);
+	atomic_fetch_add(&ctx->tableHits, worker->tableHits);
+	return NULL;
+}
+
+/*
+ * Split every task into the tasks of its placements, as long as there are too
+ * few tasks for the threads and every task keeps at least 2 tetris to place
+ */
+static struct searchTask *searchSplit(const tetrisBoard *board, const uint8_t *types, int depth, int threads, int *taskNum){
+	struct searchTask *tasks = malloc(sizeof(struct searchTask));
+	int num = 1;
+	tasks[0].board = *board;
+	tasks[0].index = 0;
+	tasks[0].depth = depth;
+	while (num < threads * searchTasksPerThread && tasks[0].depth > 2){
+		tetrisPlacement placements[perftMaxPlacements];
+		struct searchTask *split = NULL;
+		int splitNum = 0, splitSize = 0;
+		for (int t = 0; t < num; t++){
+			int count = perftPlacements(&tasks[t].board, types[tasks[t].index], placements);
+			if (splitNum + count > splitSize){
+				splitSize = 2 * (splitNum + count);
+				split = realloc(split, sizeof(struct searchTask) * splitSize);
+			}
+			for (int i = 0; i < count; i++){
+				struct searchTask *child = &split[splitNum];
+				child->board = tasks[t].board;
+				child->index = tasks[t].index + 1;
+				child->depth = tasks[t].depth - 1;
+				if (!perftPlace(&child->board, &placements[i]))
+					splitNum++; // A placement ending the game has no placements below it
+			}
+		}
+		free(tasks);
+		tasks = split;
+		num = splitNum;
+		if (!num)
+			break;
+	}
+	*taskNum = num;
+	return tasks;
+}
+
+/*
+ * Function to count the placements of a sequence of depth tetris like perftCount,
+ * with the given number of threads and a transposition table of 2^tableBits
+ * entries (no table for 0)
+ */
+uint64_t searchCount(const tetrisBoard *board, const uint8_t *types, int depth, int threads, int tableBits, searchStats *stats){
+	struct searchContext ctx;
+	int taskNum;
+	if (threads < 1)
+		threads = 1;
+	if (stats){
+		stats->tasks = 0;
+		stats->steals = 0;
+		stats->tableProbes = 0;
+		stats->tableHits = 0;
+	}
+	if (depth <= 2) // Too small to split
+		return perftCount(board, types, depth);
+
+	ctx.types = types;
+	ctx.table = tableBits ? calloc((size_t)1 << tableBits, sizeof(struct searchEntry)) : NULL;
+	ctx.tableMask = tableBits ? ((uint64_t)1 << tableBits) - 1 : 0;
+	ctx.threads = threads;
+	atomic_init(&ctx.nodes, 0);
+	atomic_init(&ctx.steals, 0);
+	atomic_init(&ctx.tableProbes, 0);
+	atomic_init(&ctx.tableHits, 0);
+
+	// Deal the tasks out to the threads in turn
+	struct searchTask *tasks = searchSplit(board, types, depth, threads, &taskNum);
+	ctx.deques = malloc(sizeof(struct searchDeque) * threads);
+	for (int n = 0; n < threads; n++){
+		pthread_mutex_init(&ctx.deques[n].lock, NULL);
+		ctx.deques[n].tasks = malloc(sizeof(struct searchTask) * (taskNum / threads + 1));
+		ctx.deques[n].head = 0;
+		ctx.deques[n].tail = 0;
+	}
+	for (int t = 0; t < taskNum; t++){
+		struct searchDeque *deque = &ctx.deques[t % threads];
+		deque->tasks[deque->tail++] = tasks[t];
+	}
+	free(tasks);
+
+	pthread_t *ids = malloc(sizeof(pthread_t) * threads);
+	struct searchWorker *workers = malloc(sizeof(struct searchWorker) * threads);
+	for (int n = 0; n < threads; n++){
+		workers[n].ctx = &ctx;
+		workers[n].id = n;
+		workers[n].tableProbes = 0;
+		workers[n].tableHits = 0;
+		pthread_create(&ids[n], NULL, searchThread, &workers[n]);
+	}
+	for (int n = 0; n < threads; n++)
+		pthread_join(ids[n], NULL);
+
+	if (stats){
+		stats->tasks = (uint64_t)taskNum;
+		stats->steals = atomic_load(&ctx.steals);
+		stats->tableProbes = atomic_load(&ctx.tableProbes);
+		stats->tableHits = atomic_load(&ctx.tableHits);
+	}
+	for (int n = 0; n < threads; n++){
+		pthread_mutex_destroy(&ctx.deques[n].lock);
+		free(ctx.deques[n].tasks);
+	}
+	free(ctx.deques);
+	free(workers);
+	free(ids);
+	free(ctx.table);
+	return atomic_load(&ctx.nodes);
+}
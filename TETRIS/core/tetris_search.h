@@ -0,0 +1,37 @@
+/**
+ * Multithreaded placement search of the TETRIS game, host only.
+ *
+ * Counts the same placements as perftCount, with the tree split by the first
+ * placements into tasks that a pool of POSIX threads works through. Every
+ * thread owns a deque of tasks and steals from the others when its own runs
+ * empty. Counts of subtrees are shared between the threads through a lockless
+ * transposition table keyed by a hash of the board, the position in the
+ * tetris sequence and the remaining depth, so boards reached again after line
+ * clears are only searched once.
+ *
+ * Needs C11 atomics and pthreads, so it is not part of the firmware.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_search_INCLUDED
+#define tetris_search_INCLUDED
+
+#include <stdint.h>
+#include "tetris_board.h"
+
+#define searchTasksPerThread 16 // Split the tree until every thread has about this many tasks
+
+struct searchStats {
+	uint64_t tasks;
+	uint64_t steals; // Tasks taken from the deque of another thread
+	uint64_t tableProbes;
+	uint64_t tableHits;
+};
+
+typedef struct searchStats searchStats;
+
+uint64_t searchBoardHash(const tetrisBoard *board);
+uint64_t searchCount(const tetrisBoard *board, const uint8_t *types, int depth, int threads, int tableBits, searchStats *stats);
+
+#endif
@@ -0,0 +1,69 @@
+/**
+ * Geometry of the 28 tetris types.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_shape.h"
+
+/*
+ * Square offsets, rotation successor, extents, row masks and the lowest square
+ * of every covered column (from the most left one) of every type.
+ * Every one of the seven shapes owns four types, so the O, I, S and Z shapes
+ * are repeated to keep the probability of all shapes balanced.
+ */
+const tetrisShapeInfo tetrisShapes[shapeTypeNum] = {
+	// x offsets,        y offsets,      next, left, right, bottom, row masks,            column bottoms
+	{{-1,  0,  0,  1}, { 0,  0,  1,  1},  1, -1, 1, 1, {0x0, 0x0, 0x3, 0x6}, { 0,  1,  1,  0}}, // Type 0
+	{{ 0, -1,  0, -1}, {-1,  0,  0,  1},  0, -1, 0, 1, {0x0, 0x2, 0x3, 0x1}, { 1,  0,  0,  0}}, // Type 1
+	{{ 0,  1, -1,  0}, { 0,  0,  1,  1},  3, -1, 1, 1, {0x0, 0x0, 0x6, 0x3}, { 1,  1,  0,  0}}, // Type 2
+	{{-1, -1,  0,  0}, {-1,  0,  0,  1},  2, -1, 0, 1, {0x0, 0x1, 0x3, 0x2}, { 0,  1,  0,  0}}, // Type 3
+	{{-1,  0,  1,  1}, { 0,  0,  0,  1},  7, -1, 1, 1, {0x0, 0x0, 0x7, 0x4}, { 0,  0,  1,  0}}, // Type 4
+	{{ 0,  0, -1,  0}, {-1,  0,  1,  1},  4, -1, 0, 1, {0x0, 0x2, 0x2, 0x3}, { 1,  1,  0,  0}}, // Type 5
+	{{-1, -1,  0,  1}, {-1,  0,  0,  0},  5, -1, 1, 0, {0x0, 0x1, 0x7, 0x0}, { 0,  0,  0,  0}}, // Type 6
+	{{ 0,  1,  0,  0}, {-1, -1,  0,  1},  6,  0, 1, 1, {0x0, 0x3, 0x1, 0x1}, { 1, -1,  0,  0}}, // Type 7
+	{{ 1, -1,  0,  1}, {-1,  0,  0,  0},  9, -1, 1, 0, {0x0, 0x4, 0x7, 0x0}, { 0,  0,  0,  0}}, // Type 8
+	{{-1,  0,  0,  0}, {-1, -1,  0,  1}, 10, -1, 0, 1, {0x0, 0x3, 0x2, 0x2}, {-1,  1,  0,  0}}, // Type 9
+	{{-1,  0,  1, -1}, { 0,  0,  0,  1}, 11, -1, 1, 1, {0x0, 0x0, 0x7, 0x1}, { 1,  0,  0,  0}}, // Type 10
+	{{ 0,  0,  0,  1}, {-1,  0,  1,  1},  8,  0, 1, 1, {0x0, 0x1, 0x1, 0x3}, { 1,  1,  0,  0}}, // Type 11
+	{{-1,  0,  0,  0}, { 0, -1,  0,  1}, 15, -1, 0, 1, {0x0, 0x2, 0x3, 0x2}, { 0,  1,  0,  0}}, // Type 12
+	{{ 0, -1,  0,  1}, {-1,  0,  0,  0}, 12, -1, 1, 0, {0x0, 0x2, 0x7, 0x0}, { 0,  0,  0,  0}}, // Type 13
+	{{ 0,  0,  0,  1}, {-1,  0,  1,  0}, 13,  0, 1, 1, {0x0, 0x1, 0x3, 0x1}, { 1,  0,  0,  0}}, // Type 14
+	{{-1,  0,  1,  0}, { 0,  0,  0,  1}, 14, -1, 1, 1, {0x0, 0x0, 0x7, 0x2}, { 0,  1,  0,  0}}, // Type 15
+	{{-1,  0, -1,  0}, { 0,  0,  1,  1}, 16, -1, 0, 1, {0x0, 0x0, 0x3, 0x3}, { 1,  1,  0,  0}}, // Type 16
+	{{ 0,  0,  0,  0}, { 0,  1, -1, -2}, 18,  0, 0, 1, {0x1, 0x1, 0x1, 0x1}, { 1,  0,  0,  0}}, // Type 17
+	{{ 0, -1,  1,  2}, { 0,  0,  0,  0}, 17, -1, 2, 0, {0x0, 0x0, 0xF, 0x0}, { 0,  0,  0,  0}}, // Type 18
+	{{-1,  0,  0,  1}, { 0,  0,  1,  1}, 20, -1, 1, 1, {0x0, 0x0, 0x3, 0x6}, { 0,  1,  1,  0}}, // Type 19
+	{{ 0, -1,  0, -1}, {-1,  0,  0,  1}, 19, -1, 0, 1, {0x0, 0x2, 0x3, 0x1}, { 1,  0,  0,  0}}, // Type 20
+	{{ 0,  1, -1,  0}, { 0,  0,  1,  1}, 22, -1, 1, 1, {0x0, 0x0, 0x6, 0x3}, { 1,  1,  0,  0}}, // Type 21
+	{{-1, -1,  0,  0}, {-1,  0,  0,  1}, 21, -1, 0, 1, {0x0, 0x1, 0x3, 0x2}, { 0,  1,  0,  0}}, // Type 22
+	{{ 0, -1, -1,  0}, { 0,  0,  1,  1}, 23, -1, 0, 1, {0x0, 0x0, 0x3, 0x3}, { 1,  1,  0,  0}}, // Type 23
+	{{ 0, -1, -1,  0}, { 0,  0,  1,  1}, 24, -1, 0, 1, {0x0, 0x0, 0x3, 0x3}, { 1,  1,  0,  0}}, // Type 24
+	{{ 0, -1, -1,  0}, { 0,  0,  1,  1}, 25, -1, 0, 1, {0x0, 0x0, 0x3, 0x3}, { 1,  1,  0,  0}}, // Type 25
+	{{ 0,  0,  0,  0}, { 0,  1, -1, -2}, 27,  0, 0, 1, {0x1, 0x1, 0x1, 0x1}, { 1,  0,  0,  0}}, // Type 26
+	{{ 0, -1,  1,  2}, { 0,  0,  0,  0}, 26, -1, 2, 0, {0x0, 0x0, 0xF, 0x0}, { 0,  0,  0,  0}}, // Type 27
+};
+
+/*
+ * Get how many rows a tetris can fall from (x, y) before it lands.
+ * As long as every column of the tetris is above the surface of the stack this
+ * only needs the column heights of the board, a tetris tucked under an overhang
+ * falls back to testing one row after the other.
+ */
+int shapeDropDistance(const tetrisBoard *board, int type, int x, int y){
+	const tetrisShapeInfo *shape = &tetrisShapes[type];
+	int distance = boardHeight;
+	for (int i = 0; i <= shape->right - shape->left; i++){
+		int col = x + shape->left + i;
+		int space = board->height[col] - 1 - (y + shape->columnBottom[i]); // Free rows below the lowest square
+		if (space < 0){
+			distance = 0;
+			while (shapeFits(board, type, x, y + distance + 1))
+				distance++;
+			return distance;
+		}
+		if (space < distance)
+			distance = space;
+	}
+	return distance;
+}
@@ -0,0 +1,68 @@
+/**
+ * Geometry of the 28 tetris types as a constant table kept in flash.
+ *
+ * Each entry holds the square offsets relative to the rotation center, the
+ * type reached by a rotation, the extents used for the wall checks and one bit
+ * mask per covered row, so a collision test is at most four AND operations
+ * against the row-mask playfield.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_shape_INCLUDED
+#define tetris_shape_INCLUDED
+
+#include <stdint.h>
+#include "tetris_board.h"
+
+#define shapeTypeNum 28
+#define shapeTopOffset (-2) // Row offset of mask[0] relative to the center
+
+struct tetrisShapeInfo {
+	int8_t x[4]; // Column offsets of the 4 squares relative to the center
+	int8_t y[4]; // Row offsets of the 4 squares relative to the center
+	uint8_t next; // Type after a counterclockwise rotation
+	int8_t left; // Most left column offset
+	int8_t right; // Most right column offset
+	int8_t bottom; // Lowest row offset
+	uint8_t mask[4]; // Rows center.y-2 to center.y+1, bit 0 is column center.x+left
+	int8_t columnBottom[4]; // Lowest row offset in the columns center.x+left to center.x+right
+};
+
+typedef struct tetrisShapeInfo tetrisShapeInfo;
+
+extern const tetrisShapeInfo tetrisShapes[shapeTypeNum];
+
+int shapeDropDistance(const tetrisBoard *board, int type, int x, int y);
+
+/*
+ * Check whether a tetris of the given type centered at (x, y) stays inside the
+ * walls and the floor without overlapping any fixed block.
+ * The sentinels of the board turn all of them into the same four AND operations,
+ * valid for any position one move or rotation away from a valid one.
+ */
+static inline int shapeFits(const tetrisBoard *board, int type, int x, int y){
+	const tetrisShapeInfo *shape = &tetrisShapes[type];
+	const uint16_t *rows = &board->rows[y + shapeTopOffset + boardHiddenRows];
+	int shift = x + shape->left + boardWallBits;
+	return !((rows[0] & (uint16_t)(shape->mask[0] << shift))
+			| (rows[1] & (uint16_t)(shape->mask[1] << shift))
+			| (rows[2] & (uint16_t)(shape->mask[2] << shift))
+			| (rows[3] & (uint16_t)(shape->mask[3] << shift)));
+}
+
+/*
+ * Get the set of playfield rows covered by a tetris of the given type centered at row y
+ */
+static inline uint32_t shapeRows(int type, int y){
+	const tetrisShapeInfo *shape = &tetrisShapes[type];
+	uint32_t rowSet = 0;
+	for (int i = 0; i <= shape->bottom - shapeTopOffset; i++){
+		int row = y + shapeTopOffset + i;
+		if (row >= 0 && shape->mask[i])
+			rowSet |= 1u << row;
+	}
+	return rowSet;
+}
+
+#endif
@@ -0,0 +1,48 @@
+/**
+ * Delayed auto shift and auto repeat of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_shift.h"
+
+/*
+ * Function to set the delay and repeat in frames with no button held
+ */
+void shiftInit(tetrisShift *shift, int delay, int repeat){
+	shift->delay = delay;
+	shift->repeat = repeat < 0 ? 0 : repeat;
+	shift->held = -1;
+	shift->timer = 0;
+}
+
+/*
+ * Function to start the delay of a pressed button, the press itself moves the tetris once
+ */
+void shiftPress(tetrisShift *shift, int button){
+	shift->held = button;
+	shift->timer = shift->delay;
+}
+
+/*
+ * Function to add frames to the held button, held tells if it is still held.
+ * Returns the moves to apply for these frames.
+ */
+int shiftAdvance(tetrisShift *shift, int held, int frames){
+	if (shift->held < 0)
+		return 0;
+	if (!held){
+		shift->held = -1;
+		return 0;
+	}
+	shift->timer -= frames;
+	if (shift->timer > 0)
+		return 0;
+	if (!shift->repeat){
+		shift->timer = 0;
+		return shiftToWall;
+	}
+	int moves = 1 + -shift->timer / shift->repeat;
+	shift->timer += moves * shift->repeat;
+	return moves;
+}
@@ -0,0 +1,34 @@
+/**
+ * Delayed auto shift and auto repeat of the TETRIS game.
+ *
+ * A held move button moves the falling tetris once when pressed, again after
+ * the delay (DAS) and then once every repeat frames (ARR). A repeat of 0 moves
+ * it to the wall at once. Time is counted in frames of the gravity timer and
+ * handed in as chunks, the moves of a chunk are applied together and drawn once.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_shift_INCLUDED
+#define tetris_shift_INCLUDED
+
+#define shiftDelayFrames 10 // 167 ms until the first repeat
+#define shiftRepeatFrames 2 // 33 ms between repeats
+#define shiftDownDelayFrames 2 // Soft drop
+#define shiftDownRepeatFrames 1
+#define shiftToWall 0x7FFF // Moves of a repeat of 0
+
+struct tetrisShift {
+	int delay; // DAS in frames
+	int repeat; // ARR in frames, 0 moves to the wall
+	int held; // Held button, -1 for none
+	int timer; // Frames until the next move
+};
+
+typedef struct tetrisShift tetrisShift;
+
+void shiftInit(tetrisShift *shift, int delay, int repeat);
+void shiftPress(tetrisShift *shift, int button);
+int shiftAdvance(tetrisShift *shift, int held, int frames);
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ * Game state snapshots of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_snapshot.h"
+#include <string.h>
+
+/*
+ * Function to empty both slots
+ */
+void snapshotInit(tetrisSnapshots *snapshots){
+	memset(snapshots, 0, sizeof(*snapshots));
+	snapshots->latest = -1;
+	snapshots->reading = -1;
+	snapshots->writing = -1;
+}
+
+/*
+ * Function to copy what a frame shows of the game into a snapshot, the sequence is set when it is published
+ */
+void snapshotCapture(tetrisSnapshot *snapshot, const tetrisGame *game, currentState state, int page){
+	snapshot->state = state;
+	snapshot->mode = game->mode;
+	snapshot->page = page;
+	snapshot->board = game->board;
+	snapshot->current = game->current;
+	snapshot->next = game->next;
+	snapshot->score = game->score;
+	snapshot->level = game->level;
+	snapshot->lines = game->lines;
+	snapshot->gravity20G = game->gravity20G;
+}
+
+/*
+ * Function to get a slot to write the next snapshot into, the one the renderer does not hold
+ */
+tetrisSnapshot *snapshotBeginWrite(tetrisSnapshots *snapshots){
+	int slot;
+	if (snapshots->reading >= 0)
+		slot = !snapshots->reading;
+	else
+		slot = snapshots->latest >= 0 ? !snapshots->latest : 0;
+	if (slot == snapshots->latest){ // The renderer is on an older snapshot, the newest one is replaced unseen
+		snapshots->latest = -1;
+		snapshots->skipped++;
+	}
+	snapshots->writing = slot;
+	return &snapshots->slots[slot];
+}
+
+/*
+ * Function to publish the snapshot written
+ */
+void snapshotEndWrite(tetrisSnapshots *snapshots){
+	int slot = snapshots->writing;
+	if (snapshots->latest >= 0 && snapshots->slots[snapshots->latest].sequence != snapshots->taken)
+		snapshots->skipped++; // The newest snapshot was never taken by the renderer
+	snapshots->slots[slot].sequence = ++snapshots->published;
+	snapshots->latest = slot;
+	snapshots->writing = -1;
+}
+
+/*
+ * Function to take the newest snapshot for rendering if it was not taken before,
+ * returns NULL otherwise. The renderer holds it until snapshotRelease.
+ */
+const tetrisSnapshot *snapshotAcquire(tetrisSnapshots *snapshots){
+	int slot = snapshots->latest;
+	if (slot < 0 || snapshots->slots[slot].sequence == snapshots->taken)
+		return NULL;
+	snapshots->reading = slot;
+	snapshots->taken = snapshots->slots[slot].sequence;
+	return &snapshots->slots[slot];
+}
+
+/*
+ * Function to give back the snapshot rendered
+ */
+void snapshotRelease(tetrisSnapshots *snapshots){
+	snapshots->reading = -1;
+	snapshots->rendered++;
+}
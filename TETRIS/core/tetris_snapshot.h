@@ -0,0 +1,66 @@
+/**
+ * Game state snapshots of the TETRIS game.
+ *
+ * The game logic publishes a copy of everything a frame shows into one of 2
+ * slots, and the renderer draws from the newest complete slot. A slot is never
+ * written while the renderer holds it, so a snapshot it reads never changes;
+ * the writer takes the other slot, giving up the newest snapshot if the
+ * renderer is still on an older one. Snapshots published faster than the
+ * renderer takes them are skipped, and counted.
+ *
+ * The exchange functions only move slot indices and must be called with a lock
+ * held, a critical section on the board and a mutex on the host. Copying a
+ * snapshot in and drawing it happen outside the lock.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_snapshot_INCLUDED
+#define tetris_snapshot_INCLUDED
+
+#include <stdint.h>
+#include "tetris_board.h"
+#include "tetris_game.h"
+
+enum snapshotPage { // Page of the pause scene
+	snapshotPause,
+	snapshotLatency
+};
+
+struct tetrisSnapshot {
+	uint32_t sequence; // 1 for the first snapshot published
+	currentState state;
+	currentMode mode;
+	int page;
+	tetrisBoard board;
+	tetrisBlock current;
+	tetrisBlock next;
+	int score, level, lines;
+	int gravity20G;
+};
+
+struct tetrisSnapshots {
+	struct tetrisSnapshot slots[2];
+	int latest; // Slot of the newest complete snapshot, -1 for none
+	int reading; // Slot held by the renderer, -1 for none
+	int writing; // Slot being written, -1 for none
+	uint32_t published;
+	uint32_t taken; // Sequence of the snapshot the renderer took last
+	uint32_t rendered;
+	uint32_t skipped; // Published and never rendered
+};
+
+typedef enum snapshotPage snapshotPage;
+typedef struct tetrisSnapshot tetrisSnapshot;
+typedef struct tetrisSnapshots tetrisSnapshots;
+
+void snapshotInit(tetrisSnapshots *snapshots);
+void snapshotCapture(tetrisSnapshot *snapshot, const tetrisGame *game, currentState state, int page);
+
+// Called with the lock held
+tetrisSnapshot *snapshotBeginWrite(tetrisSnapshots *snapshots);
+void snapshotEndWrite(tetrisSnapshots *snapshots);
+const tetrisSnapshot *snapshotAcquire(tetrisSnapshots *snapshots);
+void snapshotRelease(tetrisSnapshots *snapshots);
+
+#endif
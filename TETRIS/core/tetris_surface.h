@@ -0,0 +1,110 @@
+/**
+ * RGB565 pixel surfaces of the TETRIS game.
+ *
+ * A surface addresses the pixels of a frame buffer by the display coordinates
+ * of gdisp, whatever the orientation they are stored in: the pixel at (x, y)
+ * is origin[x * xStep + y * yStep]. The frame buffers of the board are stored
+ * in the portrait orientation of the LCD, 240 pixels a row, and turned by 90
+ * degrees for the landscape display, so moving right on the display moves a
+ * row up in memory.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_surface_INCLUDED
+#define tetris_surface_INCLUDED
+
+#include <stdint.h>
+#include <string.h>
+
+struct tetrisSurface {
+	uint16_t *origin; // Pixel (0, 0)
+	int xStep, yStep; // Pixels between 2 neighbours in x and y
+	int width, height; // Display size, drawing is clipped to it
+};
+
+struct surfaceLines { // Pixels of a rectangle in memory
+	long first; // Offset of the first pixel from the origin
+	int lines, length, step;
+};
+
+typedef struct tetrisSurface tetrisSurface;
+typedef struct surfaceLines surfaceLines;
+
+/*
+ * Surface of a frame buffer stored row by row in the display orientation
+ */
+static inline void surfaceInit(tetrisSurface *surface, uint16_t *pixels, int width, int height){
+	surface->origin = pixels;
+	surface->xStep = 1;
+	surface->yStep = width;
+	surface->width = width;
+	surface->height = height;
+}
+
+/*
+ * Surface of a frame buffer stored in the portrait orientation of the LCD,
+ * shown turned by 90 degrees as gdisp does for GDISP_ROTATE_90
+ */
+static inline void surfaceInitRotated(tetrisSurface *surface, uint16_t *pixels, int width, int height){
+	surface->origin = pixels + (width - 1) * height;
+	surface->xStep = -height;
+	surface->yStep = 1;
+	surface->width = width;
+	surface->height = height;
+}
+
+static inline uint16_t *surfacePixel(const tetrisSurface *surface, int x, int y){
+	return surface->origin + x * surface->xStep + y * surface->yStep;
+}
+
+/*
+ * Clip a rectangle to a surface and find its pixels in memory: lines of length
+ * contiguous pixels, the first one lowest in memory, step pixels apart. Returns
+ * 0 for a rectangle outside the surface.
+ */
+static inline int surfaceClip(const tetrisSurface *surface, int x, int y, int cx, int cy, surfaceLines *lines){
+	if (x < 0){
+		cx += x;
+		x = 0;
+	}
+	if (y < 0){
+		cy += y;
+		y = 0;
+	}
+	if (x + cx > surface->width)
+		cx = surface->width - x;
+	if (y + cy > surface->height)
+		cy = surface->height - y;
+	if (cx <= 0 || cy <= 0)
+		return 0;
+	int columns = surface->yStep == 1; // A column of the display is contiguous in memory
+	lines->lines = columns ? cx : cy;
+	lines->length = columns ? cy : cx;
+	lines->step = columns ? surface->xStep : surface->yStep;
+	lines->first = surfacePixel(surface, x, y) - surface->origin;
+	if (lines->step < 0){ // Start from the line lowest in memory
+		lines->first += (long)(lines->lines - 1) * lines->step;
+		lines->step = -lines->step;
+	}
+	return 1;
+}
+
+/*
+ * Copy a rectangle between 2 surfaces of the same layout, clipped to the
+ * target. The pixels contiguous in memory are copied line by line, a
+ * rectangle of whole lines as a single block.
+ */
+static inline void surfaceCopy(const tetrisSurface *target, const tetrisSurface *source, int x, int y, int cx, int cy){
+	surfaceLines lines;
+	if (!surfaceClip(target, x, y, cx, cy, &lines))
+		return;
+	if (lines.length == lines.step){
+		lines.length *= lines.lines;
+		lines.lines = 1;
+	}
+	for (int n = 0; n < lines.lines; n++, lines.first += lines.step)
+		memcpy(target->origin + lines.first, source->origin + lines.first, lines.length * sizeof(uint16_t));
+}
+
+#endif
@@ -0,0 +1,63 @@
+/**
+ * Triple buffered presentation of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_swapchain.h"
+
+/*
+ * Function to start with buffer 0 on the display and nothing presented
+ */
+void swapInit(tetrisSwapChain *chain){
+	chain->front = 0;
+	chain->ready = -1;
+	chain->drawing = -1;
+	chain->presented = 0;
+	chain->shown = 0;
+	chain->dropped = 0;
+	chain->repeated = 0;
+	chain->torn = 0;
+}
+
+/*
+ * Function to get the buffer to draw the next frame into, neither scanned out
+ * nor waiting for the vertical blank. There is always one, so it never waits.
+ */
+int swapAcquire(tetrisSwapChain *chain){
+	if (chain->drawing >= 0)
+		return chain->drawing;
+	int buffer = 0;
+	while (buffer == chain->front || buffer == chain->ready)
+		buffer++;
+	chain->drawing = buffer;
+	return buffer;
+}
+
+/*
+ * Function to present the buffer drawn, shown from the next vertical blank on
+ */
+void swapPresent(tetrisSwapChain *chain){
+	if (chain->drawing < 0)
+		return;
+	if (chain->ready >= 0)
+		chain->dropped++; // Never shown, its buffer is free again
+	chain->ready = chain->drawing;
+	chain->drawing = -1;
+	chain->presented++;
+}
+
+/*
+ * Function to switch to the newest presented frame at a vertical blank,
+ * returns the buffer to scan out from now on, or -1 to keep the current one
+ */
+int swapVBlank(tetrisSwapChain *chain){
+	if (chain->ready < 0){
+		chain->repeated++;
+		return -1;
+	}
+	chain->front = chain->ready;
+	chain->ready = -1;
+	chain->shown++;
+	return chain->front;
+}
@@ -0,0 +1,42 @@
+/**
+ * Triple buffered presentation of the TETRIS game.
+ *
+ * Of the swapBuffers frame buffers one is scanned out by the display, one may
+ * hold the newest presented frame waiting for the vertical blank, and the
+ * renderer draws into the other one. Acquiring a buffer to draw and presenting
+ * it never wait for the display: a frame presented while an older one is still
+ * waiting replaces it, and the older one is counted as dropped. The vertical
+ * blank source switches the display to the waiting frame, if any.
+ *
+ * The functions must be called with the vertical blank source held off, a
+ * critical section on the board, which the LTDC line interrupt respects.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_swapchain_INCLUDED
+#define tetris_swapchain_INCLUDED
+
+#include <stdint.h>
+
+#define swapBuffers 3
+
+struct tetrisSwapChain {
+	int front; // Buffer scanned out by the display
+	int ready; // Newest presented buffer waiting for the vertical blank, -1 for none
+	int drawing; // Buffer handed to the renderer, -1 for none
+	uint32_t presented;
+	uint32_t shown; // Presented and switched to by a vertical blank
+	uint32_t dropped; // Presented and replaced before a vertical blank
+	uint32_t repeated; // Vertical blanks without a new frame
+	uint32_t torn; // Switches which landed after the vertical blank had ended, counted by the blank source
+};
+
+typedef struct tetrisSwapChain tetrisSwapChain;
+
+void swapInit(tetrisSwapChain *chain);
+int swapAcquire(tetrisSwapChain *chain);
+void swapPresent(tetrisSwapChain *chain);
+int swapVBlank(tetrisSwapChain *chain);
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * Pre-rendered cells of the TETRIS game.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#include "tetris_tiles.h"
+
+#define tileWhite 0xFFFF
+#define tileBlack 0x0000
+
+/*
+ * Function to move an RGB565 color quarters / 4 of the way to a target color
+ */
+uint16_t tileBlend(uint16_t color, uint16_t target, int quarters){
+	static const int shifts[3] = {11, 5, 0}, masks[3] = {0x1F, 0x3F, 0x1F};
+	uint16_t blended = 0;
+	for (int channel = 0; channel < 3; channel++){
+		int from = (color >> shifts[channel]) & masks[channel];
+		int to = (target >> shifts[channel]) & masks[channel];
+		blended |= (uint16_t)((from + (to - from) * quarters / 4) << shifts[channel]);
+	}
+	return blended;
+}
+
+/*
+ * Function to get the pixel of a bevelled tile, rings of 2 pixels shaded by
+ * the nearest edge, flat at the corners between a light and a dark edge
+ */
+static uint16_t tileBevel(uint16_t color, int col, int row){
+	int last = tileSize - 1;
+	int light = col < row ? col : row; // Distance to the top or left edge
+	int dark = last - col < last - row ? last - col : last - row;
+	int ring = light < dark ? light : dark;
+	if (ring >= 2 || light == dark)
+		return color;
+	return light < dark ? tileBlend(color, tileWhite, 2 - ring) : tileBlend(color, tileBlack, 2 - ring);
+}
+
+/*
+ * Function to render the tiles of the cell colors, color 0 the empty cell, for
+ * frame buffers in the display orientation or turned like those of the board
+ */
+void tilesInit(tetrisTiles *tiles, const uint16_t colors[renderCellColors], int rotated){
+	for (int look = 0; look < tileLooks; look++){
+		tetrisSurface *surface = &tiles->surfaces[look];
+		int color = look % renderCellColors, outline = look >= renderCellColors;
+		if (rotated)
+			surfaceInitRotated(surface, tiles->pixels[look], tileSize, tileSize);
+		else
+			surfaceInit(surface, tiles->pixels[look], tileSize, tileSize);
+		for (int row = 0; row < tileSize; row++)
+			for (int col = 0; col < tileSize; col++){
+				uint16_t pixel;
+				if (outline)
+					pixel = row == 0 || col == 0 || row == tileSize - 1 || col == tileSize - 1 ? colors[color] : colors[0];
+				else
+					pixel = color ? tileBevel(colors[color], col, row) : colors[0];
+				*surfacePixel(surface, col, row) = pixel;
+			}
+	}
+}
+
+/*
+ * Function to get the tile of a look of the renderer
+ */
+const tetrisSurface *tilesLook(const tetrisTiles *tiles, int look){
+	if (look & renderOutline)
+		return &tiles->surfaces[renderCellColors + (look & ~renderOutline)];
+	return &tiles->surfaces[look];
+}
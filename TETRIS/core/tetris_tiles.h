@@ -0,0 +1,35 @@
+/**
+ * Pre-rendered cells of the TETRIS game.
+ *
+ * Every look of a cell the renderer draws, the empty cell, the 4 tetris colors
+ * and their outlines for the landing position, is rendered once into a tile of
+ * tileSize x tileSize RGB565 pixels, stored in the layout of the frame buffers
+ * so a tile is copied line by line. The tetris colors get a bevel of 2 rings,
+ * lighter towards the top left and darker towards the bottom right, the empty
+ * cell stays flat and an outline is a box of its color on the empty cell.
+ *
+ * @author: CHEN YUZONG
+ */
+
+#ifndef tetris_tiles_INCLUDED
+#define tetris_tiles_INCLUDED
+
+#include <stdint.h>
+#include "tetris_render.h"
+#include "tetris_surface.h"
+
+#define tileSize 10
+#define tileLooks (2 * renderCellColors) // Colors and their outlines
+
+struct tetrisTiles {
+	uint16_t pixels[tileLooks][tileSize * tileSize];
+	tetrisSurface surfaces[tileLooks];
+};
+
+typedef struct tetrisTiles tetrisTiles;
+
+uint16_t tileBlend(uint16_t color, uint16_t target, int quarters);
+void tilesInit(tetrisTiles *tiles, const uint16_t colors[renderCellColors], int rotated);
+const tetrisSurface *tilesLook(const tetrisTiles *tiles, int look);
+
+#endif